@@ -25,80 +25,190 @@ static constexpr uint8_t BUZZER_O2 = 4;
 
 // ベース音程
 static constexpr float BUZZER_C0_FREQ = 440.0 / BUZZER_F;
-static constexpr uint8_t BUZZER_BASE_PERIOD = 20e6 / BUZZER_C0_FREQ / 256;
+
+// Timer1 の分周比 (log2)
+// ベース音程の PWM 周期が 8bit に収まる最小の分周比を選ぶ。
+// Buzzer::begin() で Timer1 のクロック選択 (CS1[3:0]) をこの値に設定する。
+static constexpr uint8_t buzzerTimerPrescaleLog2(uint8_t n = 0) {
+  return (F_CPU >> n) / BUZZER_C0_FREQ < 256 ? n : buzzerTimerPrescaleLog2(n + 1);
+}
+static constexpr uint8_t BUZZER_TIMER_PRESCALE_LOG2 = buzzerTimerPrescaleLog2();
+static_assert(BUZZER_TIMER_PRESCALE_LOG2 <= 14, "Timer1 prescaler out of range");
+
+// Timer1 のクロック周波数 (音程と音の長さの両方の基準)
+static constexpr float BUZZER_TIMER_HZ = (float)F_CPU / (1UL << BUZZER_TIMER_PRESCALE_LOG2);
+
+static constexpr uint8_t BUZZER_BASE_PERIOD = BUZZER_TIMER_HZ / BUZZER_C0_FREQ;
+
+// 音の長さの単位 (ms)
+static constexpr uint8_t BUZZER_DURATION_UNIT_MS = 4;
 
 #define BUZZER_NOTE(oct, note, duration) \
   (uint8_t)(BUZZER_BASE_PERIOD / (BUZZER_##oct * BUZZER_##note)), (duration)
 
 #define BUZZER_FINISH() 0
 
+// Timer1 のオーバーフロー割り込みで楽譜を演奏するシーケンサ
+// ISR(TIMER1_OVF_vect) から onTimerOverflow() を呼ぶこと。
+// PWM の周期の切れ目 (オーバーフロー) でのみレジスタを書き換えるので、
+// 演奏中に別の楽譜へ切り替えても波形が乱れない。
+// 演奏していない間は割り込みを止めるので loop() 側の負荷はない。
 template<uint8_t PORT>
 class Buzzer {
 public:
+  // 楽譜キューの長さ
+  static constexpr uint8_t QUEUE_SIZE = 4;
+
+  // 音の長さ 1 単位あたりの Timer1 クロック数 (x2)
+  static constexpr uint16_t DURATION_UNIT_CLOCKS_X2 = BUZZER_TIMER_HZ * BUZZER_DURATION_UNIT_MS * 2 / 1000;
+
+  // 演奏待ちの楽譜
+  const uint8_t *queue[QUEUE_SIZE];
+  volatile uint8_t queueHead = 0;
+  volatile uint8_t queueTail = 0;
+
+  // 演奏中の楽譜を中断して次の楽譜に切り替える要求
+  volatile bool switchRequest = false;
 
   // 音符のポインタ
-  const uint8_t *cursor = nullptr;
+  const uint8_t *volatile cursor = nullptr;
 
-  // 音符の残り時間
-  uint16_t durationRemain = 0;
+  // 音符の残り時間 (単位: BUZZER_DURATION_UNIT_MS)
+  uint8_t durationRemain = 0;
+
+  // 音の長さ計測用のクロック積算値
+  uint16_t clockAccum = 0;
 
   void begin() {
-    // nothing to do
+    // Timer1 クロック選択 (CK / 2^BUZZER_TIMER_PRESCALE_LOG2)
+    TCCR1 = (TCCR1 & ~(0xf << CS10)) | ((BUZZER_TIMER_PRESCALE_LOG2 + 1) << CS10);
   }
 
   // 演奏中か否か
   bool isPlaying() {
-    return durationRemain != 0;
+    return cursor != nullptr;
   }
 
-  // サウンド再生開始
+  // サウンド再生開始 (演奏中の楽譜と演奏待ちの楽譜は破棄)
   void play(const uint8_t *ptr) {
-    // PWM 有効化
-    if (PORT == 1) {
-      TCCR1 |= (1 << PWM1A) | (3 << COM1A0);
-    } else {
-      GTCCR |= (1 << PWM1B) | (3 << COM1B0);
-    }
+    noInterrupts();
+    queueHead = queueTail;
     if (ptr) {
-      cursor = ptr;        // 音符ポインタ初期化
-      durationRemain = 0;  // 音の長さ初期化
-      update();            // 最初の音符再生
+      push(ptr);
+      switchRequest = true;
+      start();
     } else {
       // 楽譜未指定 --> 演奏停止
-      stop();
+      silence();
     }
+    interrupts();
   }
 
-  // サウンド演奏継続
-  void update() {
-    if (!cursor) {
-      // サウンド停止中
-      return;
+  // 演奏中の楽譜の後に再生 (楽譜未指定なら何もしない)
+  void enqueue(const uint8_t *ptr) {
+    if (!ptr) return;
+    noInterrupts();
+    push(ptr);
+    start();
+    interrupts();
+  }
+
+  // サウンド演奏停止
+  void stop() {
+    play(nullptr);
+  }
+
+  // Timer1 オーバーフロー割り込み (PWM 1 周期毎) の処理
+  void onTimerOverflow() {
+    if (switchRequest) {
+      // 楽譜の切り替え
+      switchRequest = false;
+      cursor = nullptr;
+    } else {
+      // 経過時間を PWM 周期から積算し、一定の時間毎に音符を進める
+      clockAccum += (uint16_t)(OCR1C + 1) * 2;
+      if (clockAccum < DURATION_UNIT_CLOCKS_X2) return;
+      clockAccum -= DURATION_UNIT_CLOCKS_X2;
+      if (--durationRemain != 0) return;
     }
+    nextNote();
+  }
 
-    if (durationRemain != 0) {
-      // 音符再生中
-      durationRemain--;
+private:
+  void push(const uint8_t *ptr) {
+    uint8_t next = (queueTail + 1) % QUEUE_SIZE;
+    if (next == queueHead) {
+      // キューが一杯なら捨てる
       return;
     }
+    queue[queueTail] = ptr;
+    queueTail = next;
+  }
 
-    // 次の音符を取得
-    uint8_t pwmPeriod = *(cursor++);  // PWM周期
-    if (!pwmPeriod) {
-      // 周期がゼロであれば演奏終了
-      stop();
-      return;
+  // 停止中なら最初の音符から演奏を開始する (割り込み禁止状態で呼ぶこと)
+  void start() {
+    if (cursor) return;
+    switchRequest = false;
+
+    // 最初の音符の周期と Duty を設定してから出力を始める
+    nextNote();
+    if (!cursor) return;
+
+    // 停止中も Timer1 は回り続けているので、古い OCR1C を超えた位置から
+    // 始まらないようにカウンタを戻してから PWM を有効化する
+    TCNT1 = 0;
+    if (PORT == 1) {
+      TCCR1 |= (1 << PWM1A) | (3 << COM1A0);
+    } else {
+      GTCCR |= (1 << PWM1B) | (3 << COM1B0);
     }
-    uint8_t duration = *(cursor++);  // 音の長さ
+    tinyio::asOutput(PORT);
 
-    OCR1C = pwmPeriod;                 // PWM 周期設定
-    analogWrite(PORT, pwmPeriod / 2);  // Duty = 50%
-    durationRemain = duration * 4;     // 音の長さ
+    // オーバーフロー割り込み有効化
+    TIFR = (1 << TOV1);
+    TIMSK |= (1 << TOIE1);
   }
 
-  // サウンド演奏停止
-  void stop() {
-    // PWM 停止
+  // 次の音符を取得
+  void nextNote() {
+    for (;;) {
+      if (!cursor) {
+        if (queueHead == queueTail) {
+          // 演奏待ちの楽譜なし --> 演奏停止
+          silence();
+          return;
+        }
+        cursor = queue[queueHead];
+        queueHead = (queueHead + 1) % QUEUE_SIZE;
+        clockAccum = 0;
+      }
+
+      uint8_t pwmPeriod = *(cursor++);  // PWM周期
+      if (!pwmPeriod) {
+        // 周期がゼロであればこの楽譜は終了
+        cursor = nullptr;
+        continue;
+      }
+      durationRemain = *(cursor++);  // 音の長さ
+      if (durationRemain == 0) {
+        // 長さゼロは約 1ms (PWM 1 周期以上) だけ鳴らす
+        durationRemain = 1;
+        clockAccum = DURATION_UNIT_CLOCKS_X2 - DURATION_UNIT_CLOCKS_X2 / BUZZER_DURATION_UNIT_MS;
+      }
+
+      OCR1C = pwmPeriod;  // PWM 周期設定
+      if (PORT == 1) {    // Duty = 50%
+        OCR1A = pwmPeriod / 2;
+      } else {
+        OCR1B = pwmPeriod / 2;
+      }
+      return;
+    }
+  }
+
+  // PWM と割り込みの停止
+  void silence() {
+    TIMSK &= ~(1 << TOIE1);
     if (PORT == 1) {
       TCCR1 &= ~((1 << PWM1A) | (3 << COM1A0));
       GTCCR |= (1 << FOC1A);
@@ -110,5 +220,6 @@ public:
     // ピン開放
     tinyio::asInput(PORT, tinyio::Pull::UP);
     cursor = nullptr;
+    switchRequest = false;
   }
 };
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------
+// バイナリ形式のデバッグログ
+//
+// 文字列を送る代わりにイベント ID と小さなペイロードを RAM 上の
+// リングバッファに積み、1 バイトずつ取り出してシリアルに送る。
+// 送信はループの空き時間に 1 tick あたり 1 バイトだけ行うので、
+// ログの量によって tick のタイミングが変わらない。
+//
+// レコードの形式:
+//   [ID] [ペイロード...]
+//   ペイロード長は ID 毎に固定 (debugEventPayloadSize)。
+//   DEBUG_LOG_VARIABLE の ID は [ID] [長さ] [ペイロード...] となる。
+//
+// バッファが一杯のときはレコード単位で捨て、次に書き込めたときに
+// 捨てた数を LOST レコードとして先に出力する。
+//
+// 受信側が途中から (レコードの途中から) 受信しても区切りを見つけられる
+// ように、STARTUP と LOST の前には SYNC レコード [SYNC] [0xa5] [0x5a] を
+// 自動的に出力する。putSync() で任意の位置にも出力できる。
+// ホスト側のデコーダは test/debug_log/ にある。
+//------------------------------------------------------------------------
+
+enum class DebugEvent : uint8_t {
+  LOST = 0,                 // 捨てたレコード数 (u8)
+  STARTUP = 1,              // 起動/スリープ復帰直後
+  STARTED_UP = 2,           // ボタン開放待ち完了
+  BUTTON_DOWN = 3,          // ボタン押下
+  BUTTON_UP = 4,            // ボタン開放
+  DICE = 5,                 // DiceEvent (u8), 数字 (u8)
+  RNG_STATE_ALL_ZERO = 6,   // 乱数状態がゼロだった
+  RNG_STATE_LOADED = 7,     // 乱数状態をロード
+  RNG_STATE_SAVED = 8,      // 乱数状態を保存
+  RNG_STATE = 9,            // 乱数状態のダンプ (可変長)
+  POWER_DOWN_TIMER = 10,    // パワーダウンまでの秒数 (u8)
+  BATTERY_CHECK_TIMER = 11, // バッテリーチェックまでの秒数 (u8)
+  BATTERY = 12,             // 1.1V の ADC 値 (u16 LE), 低電圧フラグ (u8)
+  POWER_DOWN = 13,          // パワーダウン
+  WOKE_UP = 14,             // スリープ復帰
+  SYNC = 15,                // 同期 (DEBUG_LOG_SYNC_MAGIC)
+};
+
+static constexpr uint8_t DEBUG_EVENT_COUNT = 16;
+
+// SYNC レコードのペイロード
+static constexpr uint8_t DEBUG_LOG_SYNC_MAGIC[2] = { 0xa5, 0x5a };
+
+// 可変長ペイロード
+static constexpr uint8_t DEBUG_LOG_VARIABLE = 0xff;
+
+// ID 毎のペイロード長
+static constexpr uint8_t debugEventPayloadSize(uint8_t id) {
+  return id == (uint8_t)DebugEvent::LOST                  ? 1
+         : id == (uint8_t)DebugEvent::DICE                ? 2
+         : id == (uint8_t)DebugEvent::RNG_STATE           ? DEBUG_LOG_VARIABLE
+         : id == (uint8_t)DebugEvent::POWER_DOWN_TIMER    ? 1
+         : id == (uint8_t)DebugEvent::BATTERY_CHECK_TIMER ? 1
+         : id == (uint8_t)DebugEvent::BATTERY             ? 3
+         : id == (uint8_t)DebugEvent::SYNC                ? sizeof(DEBUG_LOG_SYNC_MAGIC)
+                                                          : 0;
+}
+
+// SIZE: バッファのバイト数 (2 の累乗)
+template<uint8_t SIZE>
+class DebugLog {
+public:
+  static_assert(SIZE >= 4 && (SIZE & (SIZE - 1)) == 0, "DebugLog size must be a power of two");
+
+  static constexpr uint8_t MASK = SIZE - 1;
+
+  uint8_t buff[SIZE];
+  volatile uint8_t head = 0;  // 書き込み位置 (put 側のみ更新)
+  volatile uint8_t tail = 0;  // 読み出し位置 (pop 側のみ更新)
+  uint8_t lost = 0;           // 捨てたレコード数
+
+  // レコードを追加する
+  void put(DebugEvent id, const uint8_t *payload, uint8_t size) {
+    bool variable = debugEventPayloadSize((uint8_t)id) == DEBUG_LOG_VARIABLE;
+    uint8_t recordSize = 1 + (variable ? 1 : 0) + size;
+    // 起動時と LOST の前には SYNC を入れる
+    bool sync = (lost != 0) || (id == DebugEvent::STARTUP);
+    if (sync) recordSize += 1 + sizeof(DEBUG_LOG_SYNC_MAGIC);
+    if (lost != 0) recordSize += 2;
+    if (free() < recordSize) {
+      if (lost != 0xff) lost++;
+      return;
+    }
+    if (sync) {
+      push((uint8_t)DebugEvent::SYNC);
+      for (uint8_t b : DEBUG_LOG_SYNC_MAGIC) {
+        push(b);
+      }
+    }
+    if (lost != 0) {
+      // 先に LOST レコードを出力する
+      push((uint8_t)DebugEvent::LOST);
+      push(lost);
+      lost = 0;
+    }
+    push((uint8_t)id);
+    if (variable) push(size);
+    for (uint8_t i = 0; i < size; i++) {
+      push(payload[i]);
+    }
+    head = wr;
+  }
+
+  // SYNC レコードを追加する
+  void putSync() {
+    put(DebugEvent::SYNC, DEBUG_LOG_SYNC_MAGIC[0], DEBUG_LOG_SYNC_MAGIC[1]);
+  }
+
+  void put(DebugEvent id) {
+    put(id, nullptr, 0);
+  }
+
+  void put(DebugEvent id, uint8_t a) {
+    put(id, &a, 1);
+  }
+
+  void put(DebugEvent id, uint8_t a, uint8_t b) {
+    uint8_t payload[] = { a, b };
+    put(id, payload, sizeof(payload));
+  }
+
+  void put(DebugEvent id, uint16_t a, uint8_t b) {
+    uint8_t payload[] = { (uint8_t)a, (uint8_t)(a >> 8), b };
+    put(id, payload, sizeof(payload));
+  }
+
+  // 1 バイト取り出す。空なら false
+  bool pop(uint8_t *b) {
+    uint8_t rd = tail;
+    if (rd == head) return false;
+    *b = buff[rd];
+    tail = (rd + 1) & MASK;
+    return true;
+  }
+
+  bool isEmpty() const {
+    return head == tail;
+  }
+
+private:
+  uint8_t wr = 0;  // 書き込み中の位置 (レコードを書き終えるまで head は進めない)
+
+  // 空きバイト数 (区別のため 1 バイトは常に空ける)
+  uint8_t free() const {
+    return (tail - wr - 1) & MASK;
+  }
+
+  void push(uint8_t b) {
+    buff[wr] = b;
+    wr = (wr + 1) & MASK;
+  }
+};
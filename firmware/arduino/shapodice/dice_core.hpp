@@ -9,6 +9,10 @@ enum class DiceEvent : uint8_t {
   STOP = 2,
 };
 
+// RNG: 乱数生成器
+//   next() で乱数を返し、状態変数 state と そのバイト数 STATE_BYTES を公開すること
+//   (Xoshiro128plusplus, Xoroshiro64star, Pcg32x16, Xorshift16)
+template<typename RNG = Xoshiro128plusplus>
 class DiceCore {
 public:
   // 目の数
@@ -23,7 +27,7 @@ public:
   // サイコロ回転タイマーの周期
   static constexpr uint16_t ROLLING_TIMER_PERIOD = 32768;
 
-  Xoshiro128plusplus rng;     // 乱数生成器
+  RNG rng;                    // 乱数生成器
   bool buttonPressed = 0;     // ボタン押下状態
   uint16_t rollingSpeed = 0;  // 回転スピード
   uint16_t rollingTimer = 0;  // 回転タイマー
@@ -45,7 +49,7 @@ public:
 
   // 乱数生成器の内部状態へのポインタを返す
   uint8_t *getRngStatePtr(uint8_t *size) {
-    *size = Xoshiro128plusplus::STATE_BYTES;
+    *size = RNG::STATE_BYTES;
     return (uint8_t *)rng.state;
   }
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "tinyeeprom.hpp"
+
+//------------------------------------------------------------------------
+// EEPROM 書き込みキュー
+//
+// EEPROM.write() は 1 バイトごとに書き込み完了 (約 3.4ms) を待つため、
+// 乱数状態の保存だけで 50ms 以上ループが止まる。
+// write() は連続した 1 レコードをバッファに写すだけで戻り、実際の書き込みは
+// EE_RDY 割り込みで先頭から 1 バイトずつ行う。
+// 保留できるのは 1 レコードだけで、書き込み中の write() は失敗する。
+//
+// write() はループから、onReady() は EE_RDY 割り込みから呼ぶ。
+//------------------------------------------------------------------------
+
+// SIZE: 1 レコードの最大バイト数
+template<uint8_t SIZE>
+class EepromQueue {
+public:
+  uint8_t buff[SIZE];           // 書き込むデータ
+  uint16_t addr = 0;            // 書き込み先の先頭アドレス
+  volatile uint8_t size = 0;    // 書き込むバイト数 (0 なら空き)
+  volatile uint8_t pos = 0;     // 次に書き込むバイトの位置
+
+  // 書き込みが全て完了した
+  // (最後のバイトの完了後の EE_RDY 割り込みで size が 0 になる)
+  bool isIdle() const {
+    return size == 0;
+  }
+
+  // n バイトを dstAddr から書き込む
+  // 前のレコードの書き込み中、または大きすぎる場合は何もせずに false を返す
+  bool write(uint16_t dstAddr, const uint8_t *data, uint8_t n) {
+    if (size != 0 || n > SIZE) return false;
+    for (uint8_t i = 0; i < n; i++) {
+      buff[i] = data[i];
+    }
+    // バッファを書き終えてから公開する
+    noInterrupts();
+    addr = dstAddr;
+    pos = 0;
+    size = n;
+    tinyeeprom::enableReadyInterrupt();
+    interrupts();
+    return true;
+  }
+
+  // EE_RDY 割り込み処理
+  void onReady() {
+    uint8_t i = pos;
+    while (i < size) {
+      uint8_t data = buff[i];
+      uint16_t a = addr + i;
+      i++;
+      // 同じ値なら書き込まない
+      if (EEPROM.read(a) != data) {
+        tinyeeprom::startWrite(a, data);
+        pos = i;
+        return;
+      }
+    }
+    pos = 0;
+    size = 0;
+    tinyeeprom::disableReadyInterrupt();
+  }
+};
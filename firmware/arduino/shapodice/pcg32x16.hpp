@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------
+// PCG (32bit 状態, 16bit 出力, XSH-RR)
+// 状態 4 バイト。状態遷移は 32bit LCG、出力は上位ビットの xorshift と
+// 回転で撹拌する。状態がゼロでも動作する。
+// reference: https://www.pcg-random.org/ (pcg_oneseq_32_xsh_rr_16)
+//------------------------------------------------------------------------
+
+class Pcg32x16 {
+public:
+	using result_type = uint16_t;
+
+	static constexpr uint32_t MULTIPLIER = 747796405u;
+	static constexpr uint32_t INCREMENT = 2891336453u;
+
+	uint32_t state[1] = { 0x12345678 };
+	static constexpr uint8_t STATE_BYTES = sizeof(state);
+
+	uint16_t next(void) {
+		uint32_t old = state[0];
+		state[0] = old * MULTIPLIER + INCREMENT;
+		uint16_t x = (uint16_t)(((old >> 10) ^ old) >> 12);
+		uint8_t rot = (uint8_t)(old >> 28);
+		return (x >> rot) | (x << ((-rot) & 15));
+	}
+};
@@ -7,43 +7,31 @@
 
 #include <EEPROM.h>
 
+#include "shapodice_config.hpp"
 #include "tinyio.hpp"
 #include "tinyadc.hpp"
 #include "tinypm.hpp"
+#include "xoshiro128plusplus.hpp"
+#include "xoroshiro64star.hpp"
+#include "pcg32x16.hpp"
+#include "xorshift16.hpp"
 #include "dice_core.hpp"
 #include "dice_leds.hpp"
 #include "button.hpp"
 #include "buzzer.hpp"
+#include "debug_log.hpp"
+#include "eeprom_queue.hpp"
+#include "state_store.hpp"
 
 #if ENABLE_DEBUG_SERIAL
 #include <SoftwareSerial.h>
 #endif
 
-// ピン配置
-//        RESETn dW PCINT5 ADC0 PB5 -|￣￣￣￣|- VCC
-// XTAL1 CLKI OC1Bn PCINT3 ADC3 PB3 -|　　　　|- PB2 ADC1      PCINT2 SCK USCK SCL T0 INT0
-// XTAL2 CLKO OC1B  PCINT4 ADC2 PB4 -|　　　　|- PB1      AIN1 PCINT1 MISO DO     OC0B OC1A
-//                              GND -|＿＿＿＿|- PB0 AREF AIN0 PCINT0 MOSI DI SDA OC0A OC1An
-
-// ポート番号
-static constexpr uint8_t LED_PORT_X = 0;
-static constexpr uint8_t LED_PORT_Y = 3;
-static constexpr uint8_t LED_PORT_Z = 4;
-static constexpr uint8_t BUTTON_PORT = 2;
-static constexpr uint8_t BUZZER_PORT = 1;
-static constexpr uint8_t RESET_PORT = 5;
-
 #if !defined(ADC_INTERNAL1V1)
 #define ADC_INTERNAL1V1 (0x0C)
 #endif
 static constexpr uint8_t BATTERY_ADC = ADC_INTERNAL1V1;
 
-// バッテリー定電圧閾値 (mV)
-static constexpr uint16_t LOW_BATTERY_THRESH_MV = 3.3 * 1000;
-
-// バッテリー定電圧閾値 (ADC値)
-static constexpr uint16_t LOW_BATTERY_THRESH_ADC = 1100.0 * 1024 / LOW_BATTERY_THRESH_MV;
-
 // 起動音
 static constexpr uint8_t STARTUP_SOUND[] = {
   BUZZER_NOTE(O1, C, 24),
@@ -68,25 +56,20 @@ static constexpr uint8_t STOP_SOUND[] = {
   BUZZER_FINISH(),
 };
 
-// 起動の遅延時間
-static constexpr uint8_t STARTUP_DELAY_MS = 100;
-
-// スリープまでの時間
-static constexpr uint8_t POWER_DOWN_DELAY_SEC = 30;
-
-// 電源電圧測定間隔
-static constexpr uint8_t BATTERY_CHECK_INTERVAL_SEC = 10;
-
 // EEPROM アドレス
 static constexpr uint16_t EEPROM_ADDR_RNG_STATE = 0;
 
-DiceCore dice;
+DiceCore<DiceRng> dice;
 DiceLeds<LED_PORT_X, LED_PORT_Y, LED_PORT_Z> leds;
 Button<BUTTON_PORT> button;
+StateStore<EEPROM_ADDR_RNG_STATE, DiceRng::STATE_BYTES> rngStore;
+EepromQueue<decltype(rngStore)::SLOT_SIZE> eepromQueue;
 
 #if ENABLE_DEBUG_SERIAL
 static constexpr uint32_t DEBUG_BAUDRATE = 115200;
+static constexpr uint8_t DEBUG_LOG_SIZE = 64;
 SoftwareSerial debug(RESET_PORT, BUZZER_PORT);
+DebugLog<DEBUG_LOG_SIZE> debugLog;
 #else
 Buzzer<BUZZER_PORT> buzzer;
 #endif
@@ -111,26 +94,31 @@ static SHAPODICE_INLINE void buzzer_stop() {
 
 // clang-format off
 #if ENABLE_DEBUG_SERIAL
-#define DEBUG_PRINT(val) debug.print(val);
-#define DEBUG_PRINTLN(val) debug.println(val);
+#define DEBUG_LOG(...) debugLog.put(__VA_ARGS__)
+#define DEBUG_LOG_SYNC() debugLog.putSync()
 #else
-#define DEBUG_PRINT(val) do { } while (false)
-#define DEBUG_PRINTLN(val) do { } while (false)
+#define DEBUG_LOG(...) do { } while (false)
+#define DEBUG_LOG_SYNC() do { } while (false)
 #endif
 // clang-format on
 
-static void DEBUG_PRINTHEX(uint8_t val) {
+// デバッグログを 1 バイト送信
+static SHAPODICE_INLINE void debugDrain() {
+#if ENABLE_DEBUG_SERIAL
+  uint8_t b;
+  if (debugLog.pop(&b)) {
+    debug.write(b);
+  }
+#endif
+}
+
+// デバッグログを全て送信
+static SHAPODICE_INLINE void debugFlush() {
 #if ENABLE_DEBUG_SERIAL
-  char buf[3];
-  uint8_t tmp = val;
-  uint8_t i = 3;
-  buf[--i] = '\0';
-  do {
-    uint8_t digit = tmp & 0xf;
-    buf[--i] = ((digit < 10) ? '0' : ('a' - 10)) + digit;
-    tmp >>= 4;
-  } while (i != 0);
-  debug.print(buf);
+  uint8_t b;
+  while (debugLog.pop(&b)) {
+    debug.write(b);
+  }
 #endif
 }
 
@@ -150,8 +138,6 @@ void startup() {
   leds.begin();
 #if ENABLE_DEBUG_SERIAL
   debug.begin(DEBUG_BAUDRATE);
-  debug.print("\x1b[!p");  // DECSTR
-  debug.println();
   tinyio::asOutput(BUZZER_PORT);
 #else
   buzzer.begin();
@@ -167,6 +153,8 @@ void startup() {
   buzzer_play(STARTUP_SOUND);
 #endif
 
+  DEBUG_LOG(DebugEvent::STARTUP);
+
   // 起動直後はボタンが開放されるまでボタンに応答しない
   startupTimerMs = STARTUP_DELAY_MS;
 
@@ -199,7 +187,7 @@ void loop() {
     if (button.read() == ButtonState::UP) {
       startupTimerMs--;
       if (startupTimerMs == 0) {
-        DEBUG_PRINTLN("Started up.");
+        DEBUG_LOG(DebugEvent::STARTED_UP);
       }
     } else {
       startupTimerMs = STARTUP_DELAY_MS;
@@ -210,14 +198,14 @@ void loop() {
         // スイッチ押下 --> サイコロ回転開始
         dice.startRolling();
         leds.stopBlink();
-        DEBUG_PRINTLN("Button pushed-down.");
+        DEBUG_LOG(DebugEvent::BUTTON_DOWN);
         buzzer_play(ROLL_SOUND);
         break;
 
       case ButtonState::UP_EDGE:
         // スイッチ開放 --> サイコロ減速
         dice.startSlowdown();
-        DEBUG_PRINTLN("Button released.");
+        DEBUG_LOG(DebugEvent::BUTTON_UP);
         break;
     }
   }
@@ -245,69 +233,69 @@ void loop() {
     // 数字を LED 表示状態に反映
     uint8_t number = dice.last();
     leds.put(number);
-    DEBUG_PRINT("Event#");
-    DEBUG_PRINT((uint8_t)evt);
-    DEBUG_PRINT(", Dice number: ");
-    DEBUG_PRINTLN(number);
+    DEBUG_LOG(DebugEvent::DICE, (uint8_t)evt, number);
   }
 
   // LED のダイナミック点灯
   leds.setUserLed(lowBattery && !(milliSecCounter & 0x200));
   leds.update();
 
-// サウンド再生
-#if !(ENABLE_DEBUG_SERIAL)
-  buzzer.update();
-#endif
+  // デバッグログ送信 (1 tick あたり 1 バイト)
+  debugDrain();
 
   delay(1);
 }
 
+// EEPROM 書き込み (1 バイト完了毎)
+ISR(EE_RDY_vect) {
+  eepromQueue.onReady();
+}
+
+#if !(ENABLE_DEBUG_SERIAL)
+// サウンド再生 (PWM 1 周期毎)
+ISR(TIMER1_OVF_vect) {
+  buzzer.onTimerOverflow();
+}
+#endif
+
 // 乱数生成器の状態をロード
 void loadRngState() {
   uint8_t rngStateSize = 0;
   uint8_t* rngState = dice.getRngStatePtr(&rngStateSize);
+  rngStore.load(rngState);
   uint8_t accum = 0;
   for (uint8_t i = 0; i < rngStateSize; i++) {
-    uint8_t stateByte = EEPROM.read(EEPROM_ADDR_RNG_STATE + i);
-    accum |= stateByte;
-    rngState[i] = stateByte;
+    accum |= rngState[i];
   }
   if (accum == 0) {
     // ステートがゼロだと乱数にならないので適当に設定する
     for (uint8_t i = 0; i < rngStateSize; i++) {
       rngState[i] = i;
     }
-    DEBUG_PRINTLN("*W: RNG State all zero.");
+    DEBUG_LOG(DebugEvent::RNG_STATE_ALL_ZERO);
   }
-  DEBUG_PRINTLN("RNG state loaded.");
-#if ENABLE_DEBUG_SERIAL
+  DEBUG_LOG(DebugEvent::RNG_STATE_LOADED);
   dumpRngState();
-#endif
 }
 
 // 乱数生成器の状態を保存
+// 書き込みは EE_RDY 割り込みで行うので、完了を待たずに戻る
 void saveRngState() {
-#if ENABLE_DEBUG_SERIAL
   dumpRngState();
-#endif
   uint8_t rngStateSize = 0;
   uint8_t* rngState = dice.getRngStatePtr(&rngStateSize);
-  for (uint8_t i = 0; i < rngStateSize; i++) {
-    EEPROM.write(EEPROM_ADDR_RNG_STATE + i, rngState[i]);
+  while (!rngStore.save(eepromQueue, rngState)) {
+    // 前回の書き込みが終わっていない (通常は起こらない)
   }
-  DEBUG_PRINTLN("RNG state saved.");
+  DEBUG_LOG(DebugEvent::RNG_STATE_SAVED);
 }
 
 void dumpRngState() {
+#if ENABLE_DEBUG_SERIAL
   uint8_t rngStateSize = 0;
   uint8_t* rngState = dice.getRngStatePtr(&rngStateSize);
-  DEBUG_PRINT("RNG State: ");
-  for (uint8_t i = 0; i < rngStateSize; i++) {
-    DEBUG_PRINTHEX(rngState[i]);
-    DEBUG_PRINT(' ');
-  }
-  DEBUG_PRINTLN();
+  DEBUG_LOG(DebugEvent::RNG_STATE, rngState, rngStateSize);
+#endif
 }
 
 // LED 消灯
@@ -323,8 +311,9 @@ void resetPowerDownTimer() {
 void powerDownControl(bool pulse1sec) {
   if (powerDownTimerSec != 0) {
     if (pulse1sec) {
-      DEBUG_PRINT("Power down timer: ");
-      DEBUG_PRINTLN(powerDownTimerSec);
+      // 途中から受信を始めても 1 秒以内に同期できるようにする
+      DEBUG_LOG_SYNC();
+      DEBUG_LOG(DebugEvent::POWER_DOWN_TIMER, powerDownTimerSec);
       powerDownTimerSec--;
     }
     return;
@@ -334,11 +323,19 @@ void powerDownControl(bool pulse1sec) {
   // 全ポートを内部プルアップに設定
   tinyio::multi::asInput(0xff, tinyio::Pull::UP);
 
-  // 乱数の内部状態を保存
+  // 乱数の内部状態を保存し、書き込み完了までアイドルスリープで待つ
   saveRngState();
+  for (;;) {
+    noInterrupts();
+    if (eepromQueue.isIdle()) break;
+    tinypm::idle();
+  }
+  interrupts();
 
+  // スリープ前にデバッグログを送り切る
+  DEBUG_LOG(DebugEvent::POWER_DOWN);
+  debugFlush();
 #if ENABLE_DEBUG_SERIAL
-  debug.println("Power down...");
   debug.end();
 #endif
 
@@ -358,10 +355,7 @@ void powerDownControl(bool pulse1sec) {
   // ペリフェラル再初期化
   startup();
 
-#if ENABLE_DEBUG_SERIAL
-  debug.begin(DEBUG_BAUDRATE);
-  debug.println("Woke up.");
-#endif
+  DEBUG_LOG(DebugEvent::WOKE_UP);
 }
 
 void wakeup() {
@@ -375,8 +369,7 @@ void resetBatteryCheckTimer() {
 void batteryCheck(bool pulse1sec) {
   if (batteryCheckTimerSec != 0) {
     if (pulse1sec) {
-      DEBUG_PRINT("Battery check timer: ");
-      DEBUG_PRINTLN(batteryCheckTimerSec);
+      DEBUG_LOG(DebugEvent::BATTERY_CHECK_TIMER, batteryCheckTimerSec);
       batteryCheckTimerSec--;
     }
     return;
@@ -389,17 +382,6 @@ void batteryCheck(bool pulse1sec) {
   // 1.1V の ADC 値が閾値以上なら定電圧判定
   lowBattery = adcVal >= LOW_BATTERY_THRESH_ADC;
 
-#if ENABLE_DEBUG_SERIAL
-  uint16_t milliVolt = (uint32_t)(1.1 * 1024 * 1000) / adcVal;
-  DEBUG_PRINT("Battery ADC value: ");
-  DEBUG_PRINT(adcVal);
-  DEBUG_PRINT(" (");
-  DEBUG_PRINT(milliVolt);
-  DEBUG_PRINT("mV)");
-  if (lowBattery) {
-    DEBUG_PRINTLN(" LOW BATTERY !!");
-  } else {
-    DEBUG_PRINTLN();
-  }
-#endif
+  // 電圧 (mV) への換算はデコーダ側で行う
+  DEBUG_LOG(DebugEvent::BATTERY, adcVal, (uint8_t)lowBattery);
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include "xoshiro128plusplus.hpp"
+#include "xoroshiro64star.hpp"
+#include "pcg32x16.hpp"
+#include "xorshift16.hpp"
+
+//------------------------------------------------------------------------
+// shapodice.ino の設定値
+// ホストのシミュレータ (test/simulator) も同じ値を使うためヘッダに置く
+//------------------------------------------------------------------------
+
+// ピン配置
+//        RESETn dW PCINT5 ADC0 PB5 -|￣￣￣￣|- VCC
+// XTAL1 CLKI OC1Bn PCINT3 ADC3 PB3 -|　　　　|- PB2 ADC1      PCINT2 SCK USCK SCL T0 INT0
+// XTAL2 CLKO OC1B  PCINT4 ADC2 PB4 -|　　　　|- PB1      AIN1 PCINT1 MISO DO     OC0B OC1A
+//                              GND -|＿＿＿＿|- PB0 AREF AIN0 PCINT0 MOSI DI SDA OC0A OC1An
+
+// ポート番号
+static constexpr uint8_t LED_PORT_X = 0;
+static constexpr uint8_t LED_PORT_Y = 3;
+static constexpr uint8_t LED_PORT_Z = 4;
+static constexpr uint8_t BUTTON_PORT = 2;
+static constexpr uint8_t BUZZER_PORT = 1;
+static constexpr uint8_t RESET_PORT = 5;
+
+// バッテリー定電圧閾値 (mV)
+static constexpr uint16_t LOW_BATTERY_THRESH_MV = 3.3 * 1000;
+
+// バッテリー定電圧閾値 (ADC値)
+static constexpr uint16_t LOW_BATTERY_THRESH_ADC = 1100.0 * 1024 / LOW_BATTERY_THRESH_MV;
+
+// 起動の遅延時間
+static constexpr uint8_t STARTUP_DELAY_MS = 100;
+
+// スリープまでの時間
+static constexpr uint8_t POWER_DOWN_DELAY_SEC = 30;
+
+// 電源電圧測定間隔
+static constexpr uint8_t BATTERY_CHECK_INTERVAL_SEC = 10;
+
+// 乱数生成器 (Xoshiro128plusplus, Xoroshiro64star, Pcg32x16, Xorshift16)
+using DiceRng = Xoshiro128plusplus;
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <EEPROM.h>
+
+//------------------------------------------------------------------------
+// 電源断に耐える状態の保存
+//
+// EEPROM 上に同じ形式のスロットを 2 つ置き、保存の度に交互に書く。
+//   [データ (BYTES)] [通し番号] [CRC-16 (LE)]
+// CRC を最後に書くので、書き込み中に電源が落ちたスロットは CRC が
+// 合わなくなり、もう片方のスロットに残っている前回の状態が読まれる。
+// (壊れたバイト列の CRC が偶然一致する 1/65536 の場合を除く)
+//
+// ADDR: スロット 0 の先頭アドレス
+//       (どちらのスロットも有効でないときはスロット 0 のデータ部を
+//        そのまま読むので、以前の生のバイト列の保存形式から引き継げる)
+//------------------------------------------------------------------------
+
+template<uint16_t ADDR, uint8_t BYTES>
+class StateStore {
+public:
+  static constexpr uint8_t SLOT_SIZE = BYTES + 3;
+
+  uint8_t slot = 0;  // 最後に有効だったスロット
+  uint8_t seq = 0;   // その通し番号
+
+  static constexpr uint16_t slotAddr(uint8_t s) {
+    return ADDR + s * SLOT_SIZE;
+  }
+
+  // 状態を読み込む。有効なスロットがなければ false
+  bool load(uint8_t *data) {
+    uint8_t seq0, seq1;
+    bool valid0 = readSlot(0, &seq0);
+    bool valid1 = readSlot(1, &seq1);
+    if (valid1 && (!valid0 || (int8_t)(seq1 - seq0) > 0)) {
+      slot = 1;
+      seq = seq1;
+    } else {
+      // 有効なスロットがない場合もスロット 0 を読み、次はスロット 1 に書く
+      slot = 0;
+      seq = valid0 ? seq0 : 0;
+    }
+    uint16_t addr = slotAddr(slot);
+    for (uint8_t i = 0; i < BYTES; i++) {
+      data[i] = EEPROM.read(addr + i);
+    }
+    return valid0 || valid1;
+  }
+
+  // 前回と逆のスロットに書き込む
+  // QUEUE::write(addr, data, size) で書き込みを予約する (EepromQueue)
+  template<typename QUEUE>
+  bool save(QUEUE &queue, const uint8_t *data) {
+    uint8_t record[SLOT_SIZE];
+    uint8_t nextSeq = seq + 1;
+    for (uint8_t i = 0; i < BYTES; i++) {
+      record[i] = data[i];
+    }
+    record[BYTES] = nextSeq;
+    uint16_t crc = crc16(record, BYTES + 1);
+    record[BYTES + 1] = (uint8_t)crc;
+    record[BYTES + 2] = (uint8_t)(crc >> 8);
+    uint8_t nextSlot = slot ^ 1;
+    if (!queue.write(slotAddr(nextSlot), record, SLOT_SIZE)) return false;
+    slot = nextSlot;
+    seq = nextSeq;
+    return true;
+  }
+
+  // CRC-16/CCITT (多項式 0x1021, 初期値 0xffff)
+  static uint16_t crc16(const uint8_t *data, uint8_t size) {
+    uint16_t crc = 0xffff;
+    for (uint8_t i = 0; i < size; i++) {
+      crc ^= (uint16_t)data[i] << 8;
+      for (uint8_t b = 0; b < 8; b++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+      }
+    }
+    return crc;
+  }
+
+private:
+  static bool readSlot(uint8_t s, uint8_t *seqOut) {
+    uint8_t record[SLOT_SIZE];
+    uint16_t addr = slotAddr(s);
+    for (uint8_t i = 0; i < SLOT_SIZE; i++) {
+      record[i] = EEPROM.read(addr + i);
+    }
+    *seqOut = record[BYTES];
+    return crc16(record, BYTES + 1) == (record[BYTES + 1] | (record[BYTES + 2] << 8));
+  }
+};
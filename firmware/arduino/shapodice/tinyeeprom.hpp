@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+
+#define TINYEEPROM_INLINE inline __attribute__((always_inline))
+
+namespace tinyeeprom {
+
+// 1 バイトの書き込みを開始する (消去 + 書き込みで約 3.4ms)
+// 書き込み中でないこと。割り込み禁止の状態 (ISR 内など) で呼ぶこと
+static TINYEEPROM_INLINE void startWrite(uint16_t addr, uint8_t data) {
+  EECR &= ~((1 << EEPM1) | (1 << EEPM0));
+  EEAR = addr;
+  EEDR = data;
+  EECR |= (1 << EEMPE);
+  EECR |= (1 << EEPE);
+}
+
+// EE_RDY 割り込み (書き込み中でない間ずっと発生する)
+static TINYEEPROM_INLINE void enableReadyInterrupt() {
+  EECR |= (1 << EERIE);
+}
+
+static TINYEEPROM_INLINE void disableReadyInterrupt() {
+  EECR &= ~(1 << EERIE);
+}
+
+}
@@ -19,4 +19,15 @@ static TINYPM_INLINE void powerDown() {
   sleep_disable();
 }
 
+// 割り込みが来るまでアイドルスリープ (ペリフェラルは動作を続ける)
+// 割り込み禁止の状態で条件を確認してから呼ぶこと。
+// 割り込み許可の直後の命令でスリープするので、その間に来た割り込みでも起きられる。
+static TINYPM_INLINE void idle() {
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_enable();
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+}
+
 }
@@ -0,0 +1,65 @@
+/*  Written in 2018 by David Blackman and Sebastiano Vigna (vigna@acm.org)
+
+To the extent possible under law, the author has dedicated all copyright
+and related and neighboring rights to this software to the public domain
+worldwide.
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+//------------------------------------------------------------------------
+// Customized for Arduino sketch by Shapoco.
+// original: https://prng.di.unimi.it/xoroshiro64star.c
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+class Xoroshiro64star {
+public:
+	using result_type = uint32_t;
+
+	uint32_t state[2] = { 0x12345678, 0x9abcdef0 };
+	static constexpr uint8_t STATE_BYTES = sizeof(state);
+
+	/* This is xoroshiro64* 1.0, our best and fastest 32-bit small-state
+	   generator for 32-bit floating-point numbers. We suggest to use its
+	   upper bits for floating-point generation, as it is slightly faster than
+	   xoroshiro64**. It passes all tests we are aware of except for linearity
+	   tests, as the lowest six bits have low linear complexity, so if low
+	   linear complexity is not considered an issue (as it is usually the
+	   case) it can be used to generate 32-bit outputs, too.
+
+	   The state must be seeded so that it is not everywhere zero. */
+
+	uint32_t next(void) {
+		const uint32_t s0 = state[0];
+		uint32_t s1 = state[1];
+		const uint32_t result = s0 * 0x9E3779BB;
+
+		s1 ^= s0;
+		state[0] = rotl(s0, 26) ^ s1 ^ (s1 << 9); // a, b
+		state[1] = rotl(s1, 13); // c
+
+		return result;
+	}
+
+private:
+	// 8bit 単位の回転はバイトの入れ替えで済ませる
+	static inline uint32_t rotl(uint32_t x, uint8_t k) {
+		while (k >= 8) {
+			x = ((x << 8) & 0xffffff00) | ((x >> 24) & 0x000000ff);
+			k -= 8;
+		}
+		return (x << k) | (x >> (32 - k));
+	}
+};
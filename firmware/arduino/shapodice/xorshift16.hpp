@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------
+// 16bit xorshift (シフト量 7, 9, 8)
+// 状態 2 バイト、周期 65535。シフトの多くがバイト単位の移動で済むため
+// 8bit AVR で最も軽いが、統計的な品質と周期は他の生成器に劣る。
+// 状態は全ビットがゼロであってはならない。
+//------------------------------------------------------------------------
+
+class Xorshift16 {
+public:
+	using result_type = uint16_t;
+
+	uint16_t state[1] = { 0x1234 };
+	static constexpr uint8_t STATE_BYTES = sizeof(state);
+
+	uint16_t next(void) {
+		uint16_t x = state[0];
+		x ^= x << 7;
+		x ^= x >> 9;
+		x ^= x << 8;
+		state[0] = x;
+		return x;
+	}
+};
@@ -21,6 +21,8 @@ IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
 // original: https://prng.di.unimi.it/xoshiro128plusplus.c
 //------------------------------------------------------------------------
 
+#pragma once
+
 #include <stdint.h>
 
 static inline uint32_t rotl(uint32_t x, uint8_t k) {
@@ -33,6 +35,8 @@ static inline uint32_t rotl(uint32_t x, uint8_t k) {
 
 class Xoshiro128plusplus {
 public:
+	using result_type = uint32_t;
+
 	uint32_t state[4] = { 0x12345678 };
 	static constexpr uint8_t STATE_BYTES = sizeof(state);
 
@@ -0,0 +1,81 @@
+#pragma once
+
+//------------------------------------------------------------------------
+// ホスト PC 上でファームウェアのヘッダをビルドするための Arduino.h の代用品
+// レジスタは単なる変数として扱い、ハードウェアの動作は模擬しない
+// (複数スレッドでモデルを動かせるようにスレッドごとに持つ)
+//------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 8000000UL
+#endif
+
+// I/O ポート
+inline thread_local uint8_t PINB = 0xff;
+inline thread_local uint8_t DDRB = 0x00;
+inline thread_local uint8_t PORTB = 0x00;
+
+// Timer/Counter1
+inline thread_local uint8_t TCCR1 = 0x00;
+inline thread_local uint8_t GTCCR = 0x00;
+inline thread_local uint8_t TCNT1 = 0x00;
+inline thread_local uint8_t OCR1A = 0x00;
+inline thread_local uint8_t OCR1B = 0x00;
+inline thread_local uint8_t OCR1C = 0x00;
+inline thread_local uint8_t TIMSK = 0x00;
+inline thread_local uint8_t TIFR = 0x00;
+
+static constexpr uint8_t PWM1A = 6;
+static constexpr uint8_t COM1A0 = 4;
+static constexpr uint8_t PWM1B = 6;
+static constexpr uint8_t COM1B0 = 4;
+static constexpr uint8_t FOC1A = 2;
+static constexpr uint8_t FOC1B = 3;
+static constexpr uint8_t CS10 = 0;
+static constexpr uint8_t TOIE1 = 2;
+static constexpr uint8_t TOV1 = 2;
+
+// ADC
+inline thread_local uint8_t ADCSRA = 0x00;
+
+static constexpr uint8_t ADEN = 7;
+static constexpr uint8_t ADPS0 = 0;
+
+// 外部割り込み
+inline thread_local uint8_t GIMSK = 0x00;
+
+static constexpr uint8_t INT0 = 6;
+
+// EEPROM
+inline thread_local uint8_t EECR = 0x00;
+inline thread_local uint8_t EEDR = 0x00;
+inline thread_local uint16_t EEAR = 0x0000;
+
+static constexpr uint8_t EEPM1 = 5;
+static constexpr uint8_t EEPM0 = 4;
+static constexpr uint8_t EERIE = 3;
+static constexpr uint8_t EEMPE = 2;
+static constexpr uint8_t EEPE = 1;
+static constexpr uint8_t EERE = 0;
+
+// 割り込み許可フラグ
+inline thread_local bool interruptsEnabled = true;
+
+static inline void noInterrupts() {
+  interruptsEnabled = false;
+}
+
+static inline void interrupts() {
+  interruptsEnabled = true;
+}
+
+static inline void analogWrite(uint8_t pin, int val) {
+  (void)pin;
+  (void)val;
+}
+
+static inline void delay(unsigned long ms) {
+  (void)ms;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+//------------------------------------------------------------------------
+// EEPROM.h の代用品
+// 内容は eepromMemory に置き、書き込みは即座に反映する
+//------------------------------------------------------------------------
+
+#include <stdint.h>
+
+static constexpr uint16_t EEPROM_SIZE = 512;
+
+inline uint8_t eepromMemory[EEPROM_SIZE];
+
+struct EEPROMClass {
+  uint8_t read(uint16_t addr) {
+    return eepromMemory[addr];
+  }
+
+  void write(uint16_t addr, uint8_t data) {
+    eepromMemory[addr] = data;
+  }
+
+  void update(uint16_t addr, uint8_t data) {
+    write(addr, data);
+  }
+};
+
+inline EEPROMClass EEPROM;
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <Arduino.h>
+#include "buzzer.hpp"
+
+//------------------------------------------------------------------------
+// Buzzer (Timer1 割り込み駆動シーケンサ) のテスト
+//
+// Timer1 の動作を模擬し、PWM 1 周期 (OCR1C + 1 クロック) 毎に
+// onTimerOverflow() を呼んで演奏される音符と時刻を記録する。
+//------------------------------------------------------------------------
+
+static constexpr uint8_t BUZZER_PORT = 1;
+
+// shapodice.ino と同じ楽譜
+static constexpr uint8_t ROLL_SOUND[] = {
+  BUZZER_NOTE(O1, C, 8),
+  BUZZER_FINISH(),
+};
+
+static constexpr uint8_t STOP_SOUND[] = {
+  BUZZER_NOTE(O0, G, 24),
+  BUZZER_NOTE(O1, C, 24),
+  BUZZER_NOTE(O1, E, 24),
+  BUZZER_NOTE(O1, G, 24),
+  BUZZER_NOTE(O2, C, 24 * 4),
+  BUZZER_FINISH(),
+};
+
+// 長さゼロの音符を含む楽譜
+static constexpr uint8_t ZERO_LENGTH_SOUND[] = {
+  BUZZER_NOTE(O1, C, 0),
+  BUZZER_NOTE(O1, E, 1),
+  BUZZER_FINISH(),
+};
+
+// 1 単位あたりの Timer1 クロック数
+static constexpr double UNIT_CLOCKS = BUZZER_TIMER_HZ * BUZZER_DURATION_UNIT_MS / 1000;
+
+struct Note {
+  uint64_t start;  // 開始時刻 (Timer1 クロック)
+  uint8_t period;  // OCR1C
+};
+
+Buzzer<BUZZER_PORT> buzzer;
+uint64_t now = 0;
+std::vector<Note> notes;
+
+static bool isRunning() {
+  return (TIMSK >> TOIE1) & 1;
+}
+
+// 音符の切り替わりを記録する
+static void watch() {
+  static const uint8_t *lastCursor = nullptr;
+  if (buzzer.cursor != lastCursor && buzzer.cursor) {
+    notes.push_back({ now, OCR1C });
+  }
+  lastCursor = buzzer.cursor;
+}
+
+// Timer1 を clocks クロック分 (または停止するまで) 進める
+static void runTimer(uint64_t clocks) {
+  uint64_t end = now + clocks;
+  while (isRunning() && now < end) {
+    now += OCR1C + 1;
+    buzzer.onTimerOverflow();
+    watch();
+  }
+}
+
+static int numFail = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("  %s FAILED\n", what);
+    numFail++;
+  }
+}
+
+static void reset() {
+  buzzer.stop();
+  notes.clear();
+  now = 0;
+  watch();
+}
+
+static uint8_t notePeriod(const uint8_t *score, int i) {
+  return score[i * 2];
+}
+
+int main(int argc, char **argv) {
+  // begin() で Timer1 の分周比を設定する
+  {
+    TCCR1 = 0x0f;
+    buzzer.begin();
+    check((TCCR1 & 0x0f) == BUZZER_TIMER_PRESCALE_LOG2 + 1, "begin() sets Timer1 clock select");
+    check(BUZZER_TIMER_HZ * (1UL << BUZZER_TIMER_PRESCALE_LOG2) == F_CPU, "BUZZER_TIMER_HZ matches prescaler");
+    printf("Timer1: F_CPU / %lu = %.0f Hz\n", 1UL << BUZZER_TIMER_PRESCALE_LOG2, BUZZER_TIMER_HZ);
+  }
+
+  // 停止中に再生すると即座に最初の音符が鳴り、割り込みが有効になる
+  {
+    reset();
+    TCNT1 = 0xc8;
+    buzzer.play(STOP_SOUND);
+    watch();
+    check(TCNT1 == 0, "play() restarts Timer1 from zero");
+    check(isRunning(), "play() enables Timer1 overflow interrupt");
+    check(OCR1C == notePeriod(STOP_SOUND, 0), "play() starts the first note immediately");
+    check(DDRB & (1 << BUZZER_PORT), "play() drives the buzzer pin");
+  }
+
+  // 音符の長さは PWM 周期によらず一定の時間単位になる
+  {
+    runTimer(UINT32_MAX);
+    check(!isRunning(), "interrupt is disabled after the score ends");
+    check(!(DDRB & (1 << BUZZER_PORT)), "buzzer pin is released after the score ends");
+    check(notes.size() == 5, "all notes played");
+    double expectedTotal = 0;
+    for (size_t i = 0; i < notes.size(); i++) {
+      check(notes[i].period == notePeriod(STOP_SOUND, i), "note order");
+      expectedTotal += STOP_SOUND[i * 2 + 1] * UNIT_CLOCKS;
+      if (i + 1 < notes.size()) {
+        double len = notes[i + 1].start - notes[i].start;
+        double expected = STOP_SOUND[i * 2 + 1] * UNIT_CLOCKS;
+        // 切り替えは PWM 周期の切れ目なので 1 周期分の誤差を許す
+        check(len > expected - 256 && len < expected + 256, "note length");
+      }
+    }
+    double total = now - notes[0].start;
+    check(total > expectedTotal - 256 && total < expectedTotal + 256, "score length");
+    printf("STOP_SOUND: %.1f ms (expected %.1f ms)\n", total / BUZZER_TIMER_HZ * 1000,
+           expectedTotal / BUZZER_TIMER_HZ * 1000);
+  }
+
+  // 演奏中の play() は次の PWM 周期の切れ目で切り替わる
+  {
+    reset();
+    buzzer.play(STOP_SOUND);
+    watch();
+    runTimer(UNIT_CLOCKS * 10);
+    uint8_t before = OCR1C;
+    buzzer.play(ROLL_SOUND);
+    check(OCR1C == before, "play() during a score does not touch PWM registers");
+    runTimer(1);
+    check(OCR1C == notePeriod(ROLL_SOUND, 0), "play() switches at the next overflow");
+    runTimer(UINT32_MAX);
+    check(notes.size() == 2 && notes[1].period == notePeriod(ROLL_SOUND, 0), "interrupted score is discarded");
+  }
+
+  // enqueue() は演奏中の楽譜の後に再生する
+  {
+    reset();
+    buzzer.play(ROLL_SOUND);
+    watch();
+    buzzer.enqueue(STOP_SOUND);
+    runTimer(UINT32_MAX);
+    check(notes.size() == 6, "queued score played");
+    check(notes[0].period == notePeriod(ROLL_SOUND, 0), "current score first");
+    for (int i = 0; i < 5; i++) {
+      check(notes[1 + i].period == notePeriod(STOP_SOUND, i), "queued score order");
+    }
+  }
+
+  // 楽譜未指定の enqueue() は無視する
+  {
+    reset();
+    buzzer.enqueue(nullptr);
+    check(!isRunning() && buzzer.queueHead == buzzer.queueTail, "enqueue(nullptr) ignored while stopped");
+    buzzer.play(ROLL_SOUND);
+    watch();
+    buzzer.enqueue(nullptr);
+    runTimer(UINT32_MAX);
+    check(notes.size() == 1, "enqueue(nullptr) ignored while playing");
+  }
+
+  // キューが一杯なら捨てる (最初の 1 つはすぐに演奏が始まる)
+  {
+    reset();
+    for (int i = 0; i < 10; i++) buzzer.enqueue(ROLL_SOUND);
+    runTimer(UINT32_MAX);
+    double expected = Buzzer<BUZZER_PORT>::QUEUE_SIZE * ROLL_SOUND[1] * UNIT_CLOCKS;
+    check(now > expected - 256 * 4 && now < expected + 256 * 4, "queue overflow");
+  }
+
+  // 長さゼロの音符は約 1ms だけ鳴らす (1ms 毎の update() で次の音符に進んでいた頃と同じ)
+  {
+    reset();
+    buzzer.play(ZERO_LENGTH_SOUND);
+    watch();
+    runTimer(UINT32_MAX);
+    check(notes.size() == 2, "zero-length note played");
+    double zeroLen = notes[1].start - notes[0].start;
+    double oneMs = BUZZER_TIMER_HZ / 1000;
+    check(zeroLen >= oneMs && zeroLen < oneMs + 256, "zero-length note lasts about 1 ms");
+    double total = now - notes[0].start;
+    check(total > zeroLen + UNIT_CLOCKS - 256 && total < zeroLen + UNIT_CLOCKS + 256, "next note keeps its length");
+    printf("zero-length note: %.2f ms\n", zeroLen / BUZZER_TIMER_HZ * 1000);
+  }
+
+  // stop() で即座に停止
+  {
+    reset();
+    buzzer.play(STOP_SOUND);
+    runTimer(UNIT_CLOCKS * 10);
+    buzzer.stop();
+    check(!isRunning() && !buzzer.isPlaying(), "stop()");
+  }
+
+  check(interruptsEnabled, "interrupts re-enabled");
+
+  if (numFail == 0) {
+    printf("Test passed!\n");
+    return 0;
+  } else {
+    printf("Test failed!\n");
+    return 1;
+  }
+}
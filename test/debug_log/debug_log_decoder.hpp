@@ -0,0 +1,177 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "debug_log.hpp"
+
+//------------------------------------------------------------------------
+// DebugLog のバイト列を読める文字列に戻すデコーダ
+//
+// feed() に 1 バイトずつ与え、レコードが揃うと 1 行分の文字列を返す。
+// 文言は従来の DEBUG_PRINT による出力に合わせている。
+//
+// 最初は同期していない状態で始まり、SYNC レコードのバイト列を見つけるまで
+// 読み捨てる。不明な ID や SYNC の値の不一致を見つけたら同期を外して
+// 次の SYNC を探し直す。読み捨てたバイト数は再同期したときに報告する。
+// (ペイロード中に偶然 SYNC と同じ並びがあると誤って同期し得る)
+//------------------------------------------------------------------------
+
+class DebugLogDecoder {
+public:
+  // 1 バイト与える。レコードが完成したら line に 1 行書いて true を返す
+  bool feed(uint8_t b, std::string *line) {
+    if (!synced) return scan(b, line);
+    if (!inRecord) {
+      id = b;
+      count = 0;
+      inRecord = true;
+      if (id >= DEBUG_EVENT_COUNT) {
+        // 不明な ID
+        loseSync(&b, 1);
+        return false;
+      }
+      size = debugEventPayloadSize(id);
+      variable = (size == DEBUG_LOG_VARIABLE);
+      if (variable) size = 0;
+      if (!variable && size == 0) return finish(line);
+      return false;
+    }
+    if (variable) {
+      // 長さのバイト
+      variable = false;
+      size = b;
+      if (size == 0) return finish(line);
+      return false;
+    }
+    payload[count++] = b;
+    if (count < size) return false;
+    if (id == (uint8_t)DebugEvent::SYNC) {
+      inRecord = false;
+      if (memcmp(payload, DEBUG_LOG_SYNC_MAGIC, sizeof(DEBUG_LOG_SYNC_MAGIC)) != 0) {
+        uint8_t record[] = { id, payload[0], payload[1] };
+        loseSync(record, sizeof(record));
+      }
+      return false;
+    }
+    return finish(line);
+  }
+
+  // 同期していない間に読み捨てたバイト数
+  uint32_t skippedBytes() const {
+    return synced ? 0 : skipped;
+  }
+
+private:
+  static constexpr uint8_t SYNC_RECORD_SIZE = 1 + sizeof(DEBUG_LOG_SYNC_MAGIC);
+
+  bool synced = false;
+  uint8_t window[SYNC_RECORD_SIZE] = {};  // 直近のバイト (SYNC の検出用)
+  uint32_t skipped = 0;                  // 読み捨てたバイト数 (window 内を含む)
+
+  bool inRecord = false;
+  bool variable = false;
+  uint8_t id = 0;
+  uint8_t size = 0;
+  uint8_t count = 0;
+  uint8_t payload[255];
+
+  // 同期していない間の 1 バイト
+  bool scan(uint8_t b, std::string *line) {
+    memmove(window, window + 1, SYNC_RECORD_SIZE - 1);
+    window[SYNC_RECORD_SIZE - 1] = b;
+    skipped++;
+    if (skipped < SYNC_RECORD_SIZE) return false;
+    if (window[0] != (uint8_t)DebugEvent::SYNC) return false;
+    if (memcmp(window + 1, DEBUG_LOG_SYNC_MAGIC, sizeof(DEBUG_LOG_SYNC_MAGIC)) != 0) return false;
+    synced = true;
+    uint32_t n = skipped - SYNC_RECORD_SIZE;
+    skipped = 0;
+    if (n == 0) return false;
+    *line = format("*W: %u byte(s) skipped to resync.", (unsigned)n);
+    return true;
+  }
+
+  // 同期を外し、読んだばかりのバイト列から SYNC を探し直す
+  void loseSync(const uint8_t *bytes, uint8_t n) {
+    synced = false;
+    inRecord = false;
+    skipped = 0;
+    std::string unused;
+    for (uint8_t i = 0; i < n; i++) {
+      scan(bytes[i], &unused);
+    }
+  }
+
+  static std::string format(const char *fmt, ...) __attribute__((format(printf, 1, 2))) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return buf;
+  }
+
+  bool finish(std::string *line) {
+    inRecord = false;
+    switch ((DebugEvent)id) {
+      case DebugEvent::LOST:
+        *line = format("*W: %u log record(s) lost.", payload[0]);
+        break;
+      case DebugEvent::STARTUP:
+        *line = "Startup.";
+        break;
+      case DebugEvent::STARTED_UP:
+        *line = "Started up.";
+        break;
+      case DebugEvent::BUTTON_DOWN:
+        *line = "Button pushed-down.";
+        break;
+      case DebugEvent::BUTTON_UP:
+        *line = "Button released.";
+        break;
+      case DebugEvent::DICE:
+        *line = format("Event#%u, Dice number: %u", payload[0], payload[1]);
+        break;
+      case DebugEvent::RNG_STATE_ALL_ZERO:
+        *line = "*W: RNG State all zero.";
+        break;
+      case DebugEvent::RNG_STATE_LOADED:
+        *line = "RNG state loaded.";
+        break;
+      case DebugEvent::RNG_STATE_SAVED:
+        *line = "RNG state saved.";
+        break;
+      case DebugEvent::RNG_STATE:
+        *line = "RNG State: ";
+        for (uint8_t i = 0; i < size; i++) {
+          *line += format("%02x ", payload[i]);
+        }
+        break;
+      case DebugEvent::POWER_DOWN_TIMER:
+        *line = format("Power down timer: %u", payload[0]);
+        break;
+      case DebugEvent::BATTERY_CHECK_TIMER:
+        *line = format("Battery check timer: %u", payload[0]);
+        break;
+      case DebugEvent::BATTERY: {
+        uint16_t adcVal = payload[0] | (payload[1] << 8);
+        uint16_t milliVolt = adcVal ? (uint32_t)(1.1 * 1024 * 1000) / adcVal : 0;
+        *line = format("Battery ADC value: %u (%umV)%s", adcVal, milliVolt, payload[2] ? " LOW BATTERY !!" : "");
+        break;
+      }
+      case DebugEvent::POWER_DOWN:
+        *line = "Power down...";
+        break;
+      case DebugEvent::WOKE_UP:
+        *line = "Woke up.";
+        break;
+      case DebugEvent::SYNC:
+        // feed() で処理済み
+        return false;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "debug_log.hpp"
+#include "debug_log_decoder.hpp"
+
+//------------------------------------------------------------------------
+// DebugLog のテストとデコーダ
+//
+// 引数なし: DebugLog に積んだレコードがデコーダで元に戻ること、
+//           途中から受信しても SYNC で再同期できることを確認する
+// 引数あり: シリアルで受信したバイト列のファイルをデコードして表示する
+//           (ファイル名に - を指定すると標準入力から読む)
+//------------------------------------------------------------------------
+
+static int decodeFile(const char *path) {
+  FILE *fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+  if (!fp) {
+    perror(path);
+    return 1;
+  }
+  DebugLogDecoder decoder;
+  std::string line;
+  int c;
+  while ((c = fgetc(fp)) != EOF) {
+    if (decoder.feed((uint8_t)c, &line)) {
+      printf("%s\n", line.c_str());
+    }
+  }
+  if (decoder.skippedBytes() != 0) {
+    printf("*W: %u byte(s) skipped, no sync found.\n", (unsigned)decoder.skippedBytes());
+  }
+  if (fp != stdin) fclose(fp);
+  return 0;
+}
+
+static int numFail = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("  %s FAILED\n", what);
+    numFail++;
+  }
+}
+
+// バッファを全て取り出す
+template<uint8_t SIZE>
+static std::vector<uint8_t> drainBytes(DebugLog<SIZE> &log) {
+  std::vector<uint8_t> bytes;
+  uint8_t b;
+  while (log.pop(&b)) bytes.push_back(b);
+  return bytes;
+}
+
+static std::vector<std::string> decode(const std::vector<uint8_t> &bytes, size_t start = 0) {
+  DebugLogDecoder decoder;
+  std::vector<std::string> lines;
+  std::string line;
+  for (size_t i = start; i < bytes.size(); i++) {
+    if (decoder.feed(bytes[i], &line)) lines.push_back(line);
+  }
+  return lines;
+}
+
+// バッファを全て取り出してデコードする
+template<uint8_t SIZE>
+static std::vector<std::string> drain(DebugLog<SIZE> &log, DebugLogDecoder &decoder) {
+  std::vector<std::string> lines;
+  std::string line;
+  uint8_t b;
+  while (log.pop(&b)) {
+    if (decoder.feed(b, &line)) lines.push_back(line);
+  }
+  return lines;
+}
+
+static bool expectLines(const std::vector<std::string> &lines, const std::vector<std::string> &expected) {
+  if (lines == expected) return true;
+  for (size_t i = 0; i < lines.size() || i < expected.size(); i++) {
+    printf("    [%zu] got \"%s\", expected \"%s\"\n", i, i < lines.size() ? lines[i].c_str() : "",
+           i < expected.size() ? expected[i].c_str() : "");
+  }
+  return false;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) return decodeFile(argv[1]);
+
+  // 全種類のレコードが従来の文言に戻ること
+  {
+    DebugLog<64> log;
+    DebugLogDecoder decoder;
+    uint8_t rngState[16];
+    for (uint8_t i = 0; i < sizeof(rngState); i++) rngState[i] = i * 0x11;
+
+    log.put(DebugEvent::STARTUP);
+    log.put(DebugEvent::RNG_STATE_ALL_ZERO);
+    log.put(DebugEvent::RNG_STATE_LOADED);
+    log.put(DebugEvent::RNG_STATE, rngState, sizeof(rngState));
+    log.put(DebugEvent::RNG_STATE_SAVED);
+    std::vector<std::string> lines = drain(log, decoder);
+    log.put(DebugEvent::STARTED_UP);
+    log.put(DebugEvent::BUTTON_DOWN);
+    log.put(DebugEvent::BUTTON_UP);
+    log.put(DebugEvent::DICE, (uint8_t)1, (uint8_t)4);
+    log.put(DebugEvent::POWER_DOWN_TIMER, (uint8_t)30);
+    log.put(DebugEvent::BATTERY_CHECK_TIMER, (uint8_t)10);
+    log.put(DebugEvent::BATTERY, (uint16_t)376, (uint8_t)false);
+    log.put(DebugEvent::BATTERY, (uint16_t)400, (uint8_t)true);
+    log.put(DebugEvent::POWER_DOWN);
+    log.put(DebugEvent::WOKE_UP);
+    for (auto &l : drain(log, decoder)) lines.push_back(l);
+
+    check(expectLines(lines,
+                      {
+                        "Startup.",
+                        "*W: RNG State all zero.",
+                        "RNG state loaded.",
+                        "RNG State: 00 11 22 33 44 55 66 77 88 99 aa bb cc dd ee ff ",
+                        "RNG state saved.",
+                        "Started up.",
+                        "Button pushed-down.",
+                        "Button released.",
+                        "Event#1, Dice number: 4",
+                        "Power down timer: 30",
+                        "Battery check timer: 10",
+                        "Battery ADC value: 376 (2995mV)",
+                        "Battery ADC value: 400 (2816mV) LOW BATTERY !!",
+                        "Power down...",
+                        "Woke up.",
+                      }),
+          "decode all events");
+  }
+
+  // 1 バイトずつ取り出しながら書き込んでも (リングバッファが周回しても) 壊れないこと
+  {
+    DebugLog<16> log;
+    DebugLogDecoder decoder;
+    std::vector<std::string> lines;
+    std::string line;
+    log.putSync();
+    drain(log, decoder);
+    for (int i = 0; i < 1000; i++) {
+      log.put(DebugEvent::DICE, (uint8_t)(i % 3), (uint8_t)(i % 6));
+      // 1 tick に 1 バイト
+      for (int t = 0; t < 3; t++) {
+        uint8_t b;
+        if (log.pop(&b) && decoder.feed(b, &line)) lines.push_back(line);
+      }
+    }
+    bool ok = lines.size() == 1000;
+    for (int i = 0; ok && i < 1000; i++) {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "Event#%d, Dice number: %d", i % 3, i % 6);
+      ok &= (lines[i] == buf);
+    }
+    check(ok, "wrap around");
+    check(log.isEmpty(), "drained");
+  }
+
+  // 溢れたレコードは丸ごと捨て、捨てた数を LOST として報告すること
+  {
+    DebugLog<16> log;
+    DebugLogDecoder decoder;
+    log.putSync();
+    drain(log, decoder);
+    for (uint8_t i = 0; i < 10; i++) {
+      // 3 バイト x 5 = 15 バイトで一杯になる
+      log.put(DebugEvent::DICE, (uint8_t)1, i);
+    }
+    std::vector<std::string> lines = drain(log, decoder);
+    check(lines.size() == 5 && lines[4] == "Event#1, Dice number: 4", "records fit in buffer");
+    check(log.lost == 5, "lost count");
+
+    // 空いたら LOST を先に出力する
+    log.put(DebugEvent::BUTTON_DOWN);
+    std::vector<uint8_t> bytes = drainBytes(log);
+    const uint8_t syncRecord[] = { (uint8_t)DebugEvent::SYNC, DEBUG_LOG_SYNC_MAGIC[0], DEBUG_LOG_SYNC_MAGIC[1] };
+    check(bytes.size() > 3 && memcmp(bytes.data(), syncRecord, 3) == 0, "SYNC before LOST");
+    lines.clear();
+    std::string line;
+    for (uint8_t b : bytes) {
+      if (decoder.feed(b, &line)) lines.push_back(line);
+    }
+    check(expectLines(lines, { "*W: 5 log record(s) lost.", "Button pushed-down." }), "lost record");
+    check(log.lost == 0, "lost count cleared");
+
+    // 入りきらない可変長レコードも捨てる
+    uint8_t big[16] = {};
+    log.put(DebugEvent::RNG_STATE, big, sizeof(big));
+    check(log.isEmpty() && log.lost == 1, "oversized record dropped");
+  }
+
+  // STARTUP の前には SYNC が入る
+  {
+    DebugLog<16> log;
+    log.put(DebugEvent::STARTUP);
+    std::vector<uint8_t> bytes = drainBytes(log);
+    check(bytes == std::vector<uint8_t>({ (uint8_t)DebugEvent::SYNC, DEBUG_LOG_SYNC_MAGIC[0], DEBUG_LOG_SYNC_MAGIC[1],
+                                          (uint8_t)DebugEvent::STARTUP }),
+          "SYNC before STARTUP");
+    check(decode({ (uint8_t)DebugEvent::STARTUP }).empty(), "no output before sync");
+  }
+
+  // レコードの途中から受信を始めても、次の SYNC から正しく読める
+  {
+    DebugLog<64> log;
+    uint8_t rngState[16];
+    for (uint8_t i = 0; i < sizeof(rngState); i++) rngState[i] = i * 0x11;
+    log.put(DebugEvent::STARTUP);
+    log.put(DebugEvent::RNG_STATE, rngState, sizeof(rngState));
+    log.put(DebugEvent::DICE, (uint8_t)1, (uint8_t)4);
+    log.put(DebugEvent::BATTERY, (uint16_t)376, (uint8_t)false);
+    std::vector<uint8_t> bytes = drainBytes(log);
+    size_t resyncAt = bytes.size();
+    log.putSync();
+    log.put(DebugEvent::POWER_DOWN_TIMER, (uint8_t)29);
+    log.put(DebugEvent::BUTTON_DOWN);
+    for (uint8_t b : drainBytes(log)) bytes.push_back(b);
+
+    bool ok = true;
+    for (size_t start = 1; start <= resyncAt; start++) {
+      std::vector<std::string> expected;
+      if (start < resyncAt) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "*W: %u byte(s) skipped to resync.", (unsigned)(resyncAt - start));
+        expected.push_back(buf);
+      }
+      expected.push_back("Power down timer: 29");
+      expected.push_back("Button pushed-down.");
+      std::vector<std::string> lines = decode(bytes, start);
+      if (!expectLines(lines, expected)) {
+        printf("    (start at byte %zu)\n", start);
+        ok = false;
+        break;
+      }
+    }
+    check(ok, "resync from every offset");
+
+    // 先頭からなら全て読める
+    check(decode(bytes).size() == 6, "decode from the start");
+
+    // 不明な ID で同期を外し、次の SYNC で再同期する
+    std::vector<uint8_t> broken = bytes;
+    broken[4] = 0xee;  // STARTUP の次のレコードの ID
+    char skippedLine[64];
+    snprintf(skippedLine, sizeof(skippedLine), "*W: %u byte(s) skipped to resync.", (unsigned)(resyncAt - 4));
+    check(expectLines(decode(broken), { "Startup.", skippedLine, "Power down timer: 29", "Button pushed-down." }),
+          "resync after unknown ID");
+
+    // SYNC の値が違えば同期を外す
+    broken = bytes;
+    broken[resyncAt + 2] ^= 0xff;
+    std::vector<std::string> lines = decode(broken);
+    check(lines.size() == 4 && lines[3] == "Battery ADC value: 376 (2995mV)", "broken SYNC drops sync");
+  }
+
+  if (numFail == 0) {
+    printf("Test passed!\n");
+    return 0;
+  } else {
+    printf("Test failed!\n");
+    return 1;
+  }
+}
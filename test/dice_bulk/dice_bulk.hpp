@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------
+// 1 回の乱数から複数個のサイコロの目をまとめて取り出す
+//
+// W bit の乱数 r を固定小数点の f = r / 2^W とみなし、f に N を掛けて
+// 整数部を取り出す操作を K 回繰り返すと、floor(f * N^K) の N 進 K 桁が
+// 上位桁から順に得られる。最後に残った小数部 (r * N^K mod 2^W) が
+// 2^W mod N^K 未満のときに棄却すれば、K 桁の組は厳密に一様になる。
+// (Lemire の乗算による範囲縮小と同じ棄却条件)
+//
+// 除算を使わず、桁の取り出しは各レーン独立な乗算だけで済むので、
+// 複数の乱数をまとめて処理するとコンパイラがベクトル化できる。
+//------------------------------------------------------------------------
+
+template<typename WORD>
+struct BulkDiceWide;
+
+template<>
+struct BulkDiceWide<uint16_t> {
+  using type = uint32_t;
+};
+
+template<>
+struct BulkDiceWide<uint32_t> {
+  using type = uint64_t;
+};
+
+// n^k
+static constexpr uint64_t bulkDicePower(uint8_t n, uint8_t k) {
+  return k == 0 ? 1 : n * bulkDicePower(n, k - 1);
+}
+
+// 乱数 1 回あたりに得られる目の数の期待値 (× 2^W)
+static constexpr uint64_t bulkDiceYield(uint8_t n, uint8_t k, uint64_t range) {
+  return k * bulkDicePower(n, k) * (range / bulkDicePower(n, k));
+}
+
+// 乱数 1 回あたりの目の数の期待値が最大になる桁数
+static constexpr uint8_t bulkDiceBestDigits(uint8_t n, uint64_t range, uint8_t k = 1, uint8_t best = 1,
+                                            uint64_t bestYield = 0) {
+  return bulkDicePower(n, k) > range
+           ? best
+         : bulkDiceYield(n, k, range) > bestYield
+           ? bulkDiceBestDigits(n, range, k + 1, k, bulkDiceYield(n, k, range))
+           : bulkDiceBestDigits(n, range, k + 1, best, bestYield);
+}
+
+// N: 目の数 (出目は 0...N-1)
+// WORD: 乱数のビット幅 (RNG::result_type と一致させる)
+template<uint8_t N, typename WORD = uint32_t>
+class BulkDice {
+public:
+  static_assert(N >= 2, "BulkDice needs at least two faces");
+
+  using Wide = typename BulkDiceWide<WORD>::type;
+
+  static constexpr uint8_t WORD_BITS = sizeof(WORD) * 8;
+
+  // 乱数 1 回から取り出す目の数
+  static constexpr uint8_t DIGITS = bulkDiceBestDigits(N, (uint64_t)1 << WORD_BITS);
+
+  // N^DIGITS
+  static constexpr uint64_t SPAN = bulkDicePower(N, DIGITS);
+
+  // 棄却の閾値 (2^W mod N^DIGITS)
+  static constexpr WORD THRESHOLD = (((uint64_t)1 << WORD_BITS) % SPAN);
+
+  // まとめて処理する乱数の数
+  static constexpr uint8_t LANES = 8;
+
+  // 乱数 1 個を DIGITS 桁に展開する。棄却する場合は false を返す
+  static bool extract(WORD r, uint8_t *digits) {
+    WORD x = r;
+    for (uint8_t i = 0; i < DIGITS; i++) {
+      Wide p = (Wide)x * N;
+      digits[i] = (uint8_t)(p >> WORD_BITS);
+      x = (WORD)p;
+    }
+    return x >= THRESHOLD;
+  }
+
+  // count 個の目を out に書き込む (1 回ずつ処理する版)
+  template<typename RNG>
+  static void fillScalar(RNG &rng, uint8_t *out, size_t count) {
+    static_assert(sizeof(typename RNG::result_type) == sizeof(WORD), "RNG width must match WORD");
+    size_t n = 0;
+    uint8_t digits[DIGITS];
+    while (n < count) {
+      if (!extract((WORD)rng.next(), digits)) continue;
+      for (uint8_t i = 0; i < DIGITS && n < count; i++) {
+        out[n++] = digits[i];
+      }
+    }
+  }
+
+  // count 個の目を out に書き込む
+  // 出力と消費する乱数の数は fillScalar() と同じ
+  template<typename RNG>
+  static void fill(RNG &rng, uint8_t *out, size_t count) {
+    static_assert(sizeof(typename RNG::result_type) == sizeof(WORD), "RNG width must match WORD");
+    size_t n = 0;
+
+    // 全レーンの目が入りきる間は LANES 個ずつまとめて処理
+    while (count - n >= (size_t)LANES * DIGITS) {
+      WORD x[LANES];
+      uint8_t digits[DIGITS][LANES];
+      for (uint8_t l = 0; l < LANES; l++) {
+        x[l] = (WORD)rng.next();
+      }
+      for (uint8_t i = 0; i < DIGITS; i++) {
+        for (uint8_t l = 0; l < LANES; l++) {
+          Wide p = (Wide)x[l] * N;
+          digits[i][l] = (uint8_t)(p >> WORD_BITS);
+          x[l] = (WORD)p;
+        }
+      }
+      for (uint8_t l = 0; l < LANES; l++) {
+        if (x[l] < THRESHOLD) continue;
+        for (uint8_t i = 0; i < DIGITS; i++) {
+          out[n++] = digits[i][l];
+        }
+      }
+    }
+
+    // 残りは 1 回ずつ
+    fillScalar(rng, out + n, count - n);
+  }
+};
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "xoshiro128plusplus.hpp"
+#include "dice_bulk.hpp"
+
+//------------------------------------------------------------------------
+// BulkDice のテスト
+//
+// - 16bit 版で全ての乱数値を与え、目の組が厳密に一様であること
+// - 32bit 版が 16bit 版と同じ写像になっていること
+// - fill() と fillScalar() が同じ出目・同じ乱数消費になること
+// - next() % 6 を 1 個ずつ求める場合との速度比較
+//------------------------------------------------------------------------
+
+static int numFail = 0;
+
+static void check(bool ok, const char *what, int n) {
+  if (!ok) {
+    printf("  d%d: %s FAILED\n", n, what);
+    numFail++;
+  }
+}
+
+// 16bit の全乱数値に対して DIGITS 桁の組の出現回数が全て等しいこと
+template<uint8_t N>
+static void checkExactUniformity16() {
+  using BD = BulkDice<N, uint16_t>;
+  std::vector<uint32_t> count(BD::SPAN, 0);
+  uint8_t digits[BD::DIGITS];
+  uint32_t accepted = 0;
+  for (uint32_t r = 0; r < 0x10000; r++) {
+    if (!BD::extract((uint16_t)r, digits)) continue;
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < BD::DIGITS; i++) v = v * N + digits[i];
+    count[v]++;
+    accepted++;
+  }
+  uint32_t expected = 0x10000 / BD::SPAN;
+  bool ok = (accepted == expected * BD::SPAN);
+  for (uint32_t c : count) ok &= (c == expected);
+  check(ok, "exact uniformity (16bit, all tuples)", N);
+}
+
+// 32bit 版が floor(r * N^DIGITS / 2^32) の N 進展開と
+// Lemire の棄却条件 ((r * N^DIGITS) mod 2^32 < 2^32 mod N^DIGITS) に一致すること
+// (この写像が厳密に一様であることは 16bit 版の全数検査で確認している)
+template<uint8_t N>
+static void checkExactMapping32() {
+  using BD = BulkDice<N, uint32_t>;
+  Xoshiro128plusplus rng;
+  uint8_t digits[BD::DIGITS];
+  bool ok = true;
+  for (uint32_t i = 0; i < 0x100000; i++) {
+    // 棄却境界付近も検査する
+    uint32_t r = (i & 1) ? rng.next() : (uint32_t)(i >> 1);
+    unsigned __int128 p = (unsigned __int128)r * BD::SPAN;
+    uint64_t value = (uint64_t)(p >> 32);
+    bool accept = (uint32_t)p >= BD::THRESHOLD;
+    ok &= (BD::extract(r, digits) == accept);
+    uint64_t v = 0;
+    for (uint8_t d = 0; d < BD::DIGITS; d++) v = v * N + digits[d];
+    ok &= (v == value);
+  }
+  check(ok, "exact mapping (32bit)", N);
+}
+
+// fill() と fillScalar() の一致
+template<uint8_t N>
+static void checkAgainstScalar() {
+  using BD = BulkDice<N>;
+  const size_t counts[] = { 0, 1, 7, BD::DIGITS, (size_t)BD::LANES * BD::DIGITS - 1,
+                            (size_t)BD::LANES * BD::DIGITS, 1000, 65537 };
+  bool ok = true;
+  for (size_t count : counts) {
+    Xoshiro128plusplus a, b;
+    std::vector<uint8_t> va(count + 1, 0xff), vb(count + 1, 0xff);
+    BD::fill(a, va.data(), count);
+    BD::fillScalar(b, vb.data(), count);
+    ok &= (va == vb);
+    ok &= (memcmp(a.state, b.state, sizeof(a.state)) == 0);
+    ok &= (va[count] == 0xff);
+    for (size_t i = 0; i < count; i++) ok &= (va[i] < N);
+  }
+  check(ok, "fill() == fillScalar()", N);
+}
+
+int main(int argc, char **argv) {
+  checkExactUniformity16<2>();
+  checkExactUniformity16<3>();
+  checkExactUniformity16<5>();
+  checkExactUniformity16<6>();
+  checkExactUniformity16<7>();
+  checkExactUniformity16<10>();
+  checkExactUniformity16<12>();
+  checkExactUniformity16<20>();
+  checkExactUniformity16<100>();
+  checkExactUniformity16<255>();
+
+  checkExactMapping32<2>();
+  checkExactMapping32<3>();
+  checkExactMapping32<6>();
+  checkExactMapping32<7>();
+  checkExactMapping32<10>();
+  checkExactMapping32<20>();
+  checkExactMapping32<255>();
+
+  checkAgainstScalar<2>();
+  checkAgainstScalar<3>();
+  checkAgainstScalar<4>();
+  checkAgainstScalar<6>();
+  checkAgainstScalar<8>();
+  checkAgainstScalar<10>();
+  checkAgainstScalar<12>();
+  checkAgainstScalar<20>();
+  checkAgainstScalar<100>();
+  checkAgainstScalar<255>();
+
+  // 速度比較
+  {
+    constexpr size_t N = 1 << 26;
+    std::vector<uint8_t> buf(N);
+
+    Xoshiro128plusplus rng;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < N; i++) buf[i] = rng.next() % 6;
+    double naive = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    uint32_t sumNaive = 0;
+    for (uint8_t v : buf) sumNaive += v;
+
+    t0 = std::chrono::steady_clock::now();
+    BulkDice<6>::fill(rng, buf.data(), N);
+    double bulk = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    uint32_t sumBulk = 0;
+    for (uint8_t v : buf) sumBulk += v;
+
+    printf("d6 x %zu: next() %% 6: %.3f sec, BulkDice<6>::fill(): %.3f sec (%.1fx, %u faces/draw)\n",
+           N, naive, bulk, naive / bulk, (unsigned)BulkDice<6>::DIGITS);
+    printf("  mean: %.4f / %.4f\n", (double)sumNaive / N, (double)sumBulk / N);
+  }
+
+  if (numFail == 0) {
+    printf("Test passed!\n");
+    return 0;
+  } else {
+    printf("Test failed!\n");
+    return 1;
+  }
+}
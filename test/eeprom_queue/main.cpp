@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "xoshiro128plusplus.hpp"
+#include "eeprom_queue.hpp"
+#include "state_store.hpp"
+
+//------------------------------------------------------------------------
+// EepromQueue / StateStore のテスト
+//
+// EEPROM の書き込み (EEPE のセットから完了まで 3.4ms) と EE_RDY 割り込みを
+// 模擬し、任意の時刻で電源を落としても保存済みの状態が失われないことを確認する。
+//------------------------------------------------------------------------
+
+static constexpr uint16_t ADDR = 0;
+static constexpr uint8_t BYTES = Xoshiro128plusplus::STATE_BYTES;
+static constexpr uint32_t WRITE_US = 3400;
+
+using Store = StateStore<ADDR, BYTES>;
+using Queue = EepromQueue<Store::SLOT_SIZE>;
+
+// EEPROM ハードウェアの模擬
+struct MockEeprom {
+  uint64_t now = 0;        // 現在時刻 (us)
+  bool writing = false;    // 書き込み中
+  uint16_t addr = 0;       // 書き込み中のアドレス
+  uint8_t data = 0;        // 書き込み中のデータ
+  uint64_t doneAt = 0;     // 書き込み完了時刻
+  uint32_t numWrites = 0;  // 書き込んだバイト数
+  bool protocolError = false;
+
+  // 時刻 until まで進める
+  void run(Queue &queue, uint64_t until) {
+    while (true) {
+      if ((EECR & (1 << EEPE)) && !writing) {
+        // EEMPE を立ててから EEPE を立てた場合のみ書き込みが始まる
+        protocolError |= !(EECR & (1 << EEMPE));
+        protocolError |= (EECR & ((1 << EEPM1) | (1 << EEPM0))) != 0;
+        EECR &= ~(1 << EEMPE);
+        writing = true;
+        addr = EEAR;
+        data = EEDR;
+        doneAt = now + WRITE_US;
+        numWrites++;
+      }
+      if (!writing) {
+        if (EECR & (1 << EERIE)) {
+          // EE_RDY 割り込み
+          queue.onReady();
+          continue;
+        }
+        now = until;
+        return;
+      }
+      if (doneAt > until) {
+        now = until;
+        return;
+      }
+      now = doneAt;
+      eepromMemory[addr] = data;
+      writing = false;
+      EECR &= ~(1 << EEPE);
+    }
+  }
+
+  // 書き込みが全て終わるまで進める
+  void drain(Queue &queue) {
+    while (!queue.isIdle()) run(queue, now + WRITE_US);
+    run(queue, now);
+  }
+
+  // 電源断: 書き込み中のバイトは不定値になり、レジスタは初期化される
+  void brownOut(uint8_t torn) {
+    if (writing) eepromMemory[addr] = torn;
+    writing = false;
+    EECR = 0;
+  }
+};
+
+static int numFail = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("  %s FAILED\n", what);
+    numFail++;
+  }
+}
+
+// 電源投入後の RAM (キューとストア) は毎回作り直す
+struct Device {
+  Queue queue;
+  Store store;
+  uint8_t state[BYTES];
+
+  bool boot() {
+    return store.load(state);
+  }
+};
+
+static void randomState(Xoshiro128plusplus &rng, uint8_t *state) {
+  for (uint8_t i = 0; i < BYTES; i++) state[i] = (uint8_t)rng.next();
+}
+
+int main(int argc, char **argv) {
+  Xoshiro128plusplus rng;
+
+  // 消去済みの EEPROM には有効なスロットがない
+  {
+    memset(eepromMemory, 0xff, sizeof(eepromMemory));
+    Device dev;
+    check(!dev.boot(), "erased EEPROM has no valid slot");
+    memset(eepromMemory, 0x00, sizeof(eepromMemory));
+    check(!dev.boot(), "zeroed EEPROM has no valid slot");
+  }
+
+  // 以前の形式 (先頭に生の状態バイト列) を引き継ぎ、それを上書きせずに保存する
+  {
+    MockEeprom ee;
+    memset(eepromMemory, 0xff, sizeof(eepromMemory));
+    uint8_t legacy[BYTES];
+    randomState(rng, legacy);
+    memcpy(eepromMemory + ADDR, legacy, BYTES);
+    Device dev;
+    check(!dev.boot(), "legacy layout is not a valid slot");
+    check(memcmp(dev.state, legacy, BYTES) == 0, "legacy state loaded");
+    dev.state[0]++;
+    check(dev.store.save(dev.queue, dev.state), "save");
+    ee.drain(dev.queue);
+    check(memcmp(eepromMemory + ADDR, legacy, BYTES) == 0, "legacy state kept on first save");
+    Device dev2;
+    check(dev2.boot() && memcmp(dev2.state, dev.state, BYTES) == 0, "saved state loaded after legacy");
+  }
+
+  // save() は書き込みを待たずに戻り、割り込みで書き込まれる
+  {
+    MockEeprom ee;
+    memset(eepromMemory, 0xff, sizeof(eepromMemory));
+    Device dev;
+    dev.boot();
+    randomState(rng, dev.state);
+    uint8_t before[EEPROM_SIZE];
+    memcpy(before, eepromMemory, sizeof(before));
+    check(dev.store.save(dev.queue, dev.state), "save");
+    check(memcmp(before, eepromMemory, sizeof(before)) == 0, "save() does not write synchronously");
+    check(!dev.queue.isIdle(), "queue busy after save()");
+    ee.run(dev.queue, 0);
+    check(!dev.queue.isIdle(), "busy while the first byte is being written");
+    ee.drain(dev.queue);
+    check(dev.queue.isIdle() && !(EECR & (1 << EERIE)), "interrupt disabled when drained");
+    check(!ee.protocolError, "write protocol");
+    printf("save(): returned immediately, persisted in background after %.1f ms (%u bytes)\n", ee.now / 1000.0,
+           (unsigned)ee.numWrites);
+    printf("  blocking EEPROM.write() of the raw state: %.1f ms\n", BYTES * WRITE_US / 1000.0);
+    printf("  RAM: EepromQueue %zu bytes (host layout)\n", sizeof(Queue));
+
+    // 前回の書き込みが終わるまでは受け付けない
+    check(dev.store.save(dev.queue, dev.state), "save");
+    check(!dev.store.save(dev.queue, dev.state), "save() refuses while a record is pending");
+    check(interruptsEnabled, "interrupts re-enabled after write()");
+    uint8_t big[Store::SLOT_SIZE + 1] = {};
+    Queue q;
+    check(!q.write(0, big, sizeof(big)) && q.isIdle(), "write() refuses an oversized record");
+    ee.drain(dev.queue);
+
+    // 同じ値のバイトは書き込まない (通し番号と CRC だけが変わる)
+    check(dev.store.save(dev.queue, dev.state), "save");
+    uint32_t writesBefore = ee.numWrites;
+    ee.drain(dev.queue);
+    check(ee.numWrites - writesBefore <= 3, "unchanged bytes are skipped");
+  }
+
+  // 保存の途中のあらゆる時刻で電源を落としても、前回か今回の状態が読める
+  {
+    MockEeprom ee;
+    memset(eepromMemory, 0xff, sizeof(eepromMemory));
+    Device dev;
+    dev.boot();
+    randomState(rng, dev.state);
+    dev.store.save(dev.queue, dev.state);
+    ee.drain(dev.queue);
+
+    const uint8_t tornValues[] = { 0x00, 0xff, 0x5a };
+    uint32_t numCuts = 0;
+    for (int gen = 0; gen < 4; gen++) {
+      Device cur;
+      check(cur.boot(), "boot");
+      uint8_t prev[BYTES], next[BYTES];
+      memcpy(prev, cur.state, BYTES);
+      randomState(rng, next);
+      uint8_t snapshot[EEPROM_SIZE];
+      memcpy(snapshot, eepromMemory, sizeof(snapshot));
+      uint64_t total = (uint64_t)Store::SLOT_SIZE * WRITE_US;
+      for (uint64_t t = 0; t <= total + WRITE_US; t += 97) {
+        for (uint8_t torn : tornValues) {
+          memcpy(eepromMemory, snapshot, sizeof(snapshot));
+          MockEeprom cut;
+          Device d;
+          d.boot();
+          d.store.save(d.queue, next);
+          cut.run(d.queue, t);
+          cut.brownOut(torn);
+
+          Device after;
+          bool valid = after.boot();
+          bool isPrev = memcmp(after.state, prev, BYTES) == 0;
+          bool isNext = memcmp(after.state, next, BYTES) == 0;
+          check(valid && (isPrev || isNext), "brown-out keeps the previous or the new state");
+          if (t >= total) check(isNext, "completed save survives brown-out");
+          numCuts++;
+        }
+      }
+      // 次の世代は完了した状態から
+      memcpy(eepromMemory, snapshot, sizeof(snapshot));
+      Device d;
+      d.boot();
+      d.store.save(d.queue, next);
+      MockEeprom full;
+      full.drain(d.queue);
+    }
+    printf("brown-out sweep: %u cuts\n", (unsigned)numCuts);
+  }
+
+  // 起動・保存・電源断をランダムに繰り返す
+  {
+    memset(eepromMemory, 0xff, sizeof(eepromMemory));
+    uint8_t committed[BYTES], pending[BYTES];
+    bool hasCommitted = false, hasPending = false;
+    bool ok = true;
+    for (int i = 0; i < 20000; i++) {
+      Device dev;
+      bool valid = dev.boot();
+      if (hasCommitted) {
+        bool isCommitted = memcmp(dev.state, committed, BYTES) == 0;
+        bool isPending = hasPending && memcmp(dev.state, pending, BYTES) == 0;
+        ok &= valid && (isCommitted || isPending);
+      }
+      if (valid) {
+        // 読めた状態が確定した状態になる
+        memcpy(committed, dev.state, BYTES);
+        hasCommitted = true;
+      }
+      randomState(rng, pending);
+      hasPending = true;
+      dev.store.save(dev.queue, pending);
+      MockEeprom ee;
+      ee.run(dev.queue, rng.next() % ((Store::SLOT_SIZE + 2) * WRITE_US));
+      if (dev.queue.isIdle()) {
+        memcpy(committed, pending, BYTES);
+        hasCommitted = true;
+        hasPending = false;
+      }
+      ee.brownOut((uint8_t)rng.next());
+    }
+    check(ok, "random brown-outs never lose the state");
+  }
+
+  if (numFail == 0) {
+    printf("Test passed!\n");
+    return 0;
+  } else {
+    printf("Test failed!\n");
+    return 1;
+  }
+}
@@ -0,0 +1,446 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "firmware_model.hpp"
+
+//------------------------------------------------------------------------
+// Button/DiceCore 状態機械の網羅的状態空間探索
+//
+// ファームウェアモデルに対して、全ての入力系列を深さ制限付きの幅優先で
+// 展開し、到達可能な状態で不変条件が成り立つことを確認する。
+// 状態はハッシュで重複排除し、各深さの展開はワークスティーリングで
+// 複数スレッドに分散する。違反が見つかった場合は最短の反例を表示する。
+//------------------------------------------------------------------------
+
+using namespace sim;
+
+// 入力の選択肢
+enum class Action : uint8_t {
+  RELEASE_1,     // ボタンを離して 1 tick
+  PRESS_1,       // ボタンを押して 1 tick
+  RELEASE_WAIT,  // ボタンを離したまま次のイベントまで
+  PRESS_WAIT,    // ボタンを押したまま次のイベントまで
+};
+static constexpr int NUM_ACTIONS = 4;
+
+static const char *actionName(Action a) {
+  switch (a) {
+    case Action::RELEASE_1: return "release 1 tick";
+    case Action::PRESS_1: return "press 1 tick";
+    case Action::RELEASE_WAIT: return "release until event";
+    case Action::PRESS_WAIT: return "press until event";
+  }
+  return "?";
+}
+
+static const char *eventName(SimEvent e) {
+  switch (e) {
+    case SimEvent::STARTED_UP: return "STARTED_UP";
+    case SimEvent::BUTTON_DOWN: return "BUTTON_DOWN";
+    case SimEvent::BUTTON_UP: return "BUTTON_UP";
+    case SimEvent::ROLL: return "ROLL";
+    case SimEvent::STOP: return "STOP";
+    case SimEvent::BATTERY_CHECK: return "BATTERY_CHECK";
+    case SimEvent::POWER_DOWN: return "POWER_DOWN";
+    case SimEvent::WAKE_UP: return "WAKE_UP";
+  }
+  return "?";
+}
+
+// 次のイベントを待つ上限 (tick)
+static constexpr uint32_t WAIT_LIMIT = 60000;
+
+// バッテリーの ADC 値 (3.6V 相当)
+static constexpr uint16_t BATTERY_ADC = 1100.0 * 1024 / 3600;
+
+// 不変条件
+struct Invariant {
+  const char *name;
+  bool expectViolation;  // 到達性の確認用 (反例が見つかるべきもの)
+};
+
+enum : uint8_t {
+  INV_STOP_AFTER_RELEASE,
+  INV_UP_AFTER_DOWN,
+  INV_NO_POWER_DOWN_WHILE_ROLLING,
+  INV_NO_POWER_DOWN_WHILE_PRESSED,
+  PROBE_STOP_UNREACHABLE,
+  PROBE_WAKE_UP_UNREACHABLE,
+  NUM_INVARIANTS,
+};
+
+static const Invariant INVARIANTS[NUM_INVARIANTS] = {
+  { "no STOP without a prior release", false },
+  { "no release accepted without a prior press", false },
+  { "power-down never happens while rolling", false },
+  { "power-down never happens while the button is pressed", false },
+  { "probe: STOP is unreachable", true },
+  { "probe: WAKE_UP is unreachable", true },
+};
+
+// 不変条件の監視用の状態
+struct Monitor {
+  bool downAccepted = false;
+  bool releaseAccepted = false;
+};
+
+struct Node {
+  FirmwareModel fw;
+  Monitor mon;
+  uint32_t parent;
+  Action action;
+};
+
+// 1 つの入力を与えて状態を進め、違反した不変条件のビットマスクを返す
+static uint32_t applyAction(FirmwareModel &fw, Monitor &mon, Action action, std::vector<TraceEntry> &events) {
+  bool pressed = (action == Action::PRESS_1 || action == Action::PRESS_WAIT);
+  events.clear();
+  fw.trace = &events;
+  fw.batteryAdc = BATTERY_ADC;
+
+  if (action == Action::RELEASE_1 || action == Action::PRESS_1) {
+    fw.step(pressed);
+  } else {
+    uint32_t elapsed = 0;
+    while (elapsed < WAIT_LIMIT) {
+      if (fw.sleeping && !pressed) break;
+      uint32_t n = fw.quietTicks(pressed);
+      if (n > WAIT_LIMIT - elapsed) n = WAIT_LIMIT - elapsed;
+      if (n > 0) {
+        fw.skip(n, pressed);
+        elapsed += n;
+      } else {
+        fw.step(pressed);
+        elapsed++;
+        if (!events.empty()) break;
+      }
+    }
+  }
+  fw.trace = nullptr;
+
+  uint32_t violated = 0;
+  for (auto &e : events) {
+    switch (e.event) {
+      case SimEvent::BUTTON_DOWN:
+        mon.downAccepted = true;
+        mon.releaseAccepted = false;
+        break;
+
+      case SimEvent::BUTTON_UP:
+        if (!mon.downAccepted) violated |= 1 << INV_UP_AFTER_DOWN;
+        mon.downAccepted = false;
+        mon.releaseAccepted = true;
+        break;
+
+      case SimEvent::STOP:
+        if (!mon.releaseAccepted) violated |= 1 << INV_STOP_AFTER_RELEASE;
+        mon.releaseAccepted = false;
+        violated |= 1 << PROBE_STOP_UNREACHABLE;
+        break;
+
+      case SimEvent::POWER_DOWN:
+        if (fw.dice.isRolling()) violated |= 1 << INV_NO_POWER_DOWN_WHILE_ROLLING;
+        if (fw.button.isPressed) violated |= 1 << INV_NO_POWER_DOWN_WHILE_PRESSED;
+        break;
+
+      case SimEvent::WAKE_UP:
+        violated |= 1 << PROBE_WAKE_UP_UNREACHABLE;
+        break;
+
+      default:
+        break;
+    }
+  }
+  return violated;
+}
+
+static uint64_t stateKey(const Node &node) {
+  uint64_t h = node.fw.controlHash();
+  h ^= (node.mon.downAccepted ? 0x9e3779b97f4a7c15ull : 0);
+  h ^= (node.mon.releaseAccepted ? 0xc2b2ae3d27d4eb4full : 0);
+  return h;
+}
+
+// ロック分割したハッシュ集合
+class VisitedSet {
+public:
+  static constexpr int NUM_SHARDS = 64;
+
+  bool insert(uint64_t key) {
+    Shard &s = shards[(key >> 58) % NUM_SHARDS];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.keys.insert(key).second;
+  }
+
+  size_t size() {
+    size_t n = 0;
+    for (auto &s : shards) n += s.keys.size();
+    return n;
+  }
+
+private:
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_set<uint64_t> keys;
+  };
+  Shard shards[NUM_SHARDS];
+};
+
+// ワークスティーリング用の両端キュー (要素はノード番号の範囲)
+class WorkQueue {
+public:
+  struct Range {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  void push(Range r) {
+    std::lock_guard<std::mutex> lock(mutex);
+    q.push_back(r);
+  }
+
+  // 自分のキューは後ろから取る
+  bool pop(Range *r) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (q.empty()) return false;
+    *r = q.back();
+    q.pop_back();
+    return true;
+  }
+
+  // 他のスレッドのキューは前から盗む
+  bool steal(Range *r) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (q.empty()) return false;
+    *r = q.front();
+    q.pop_front();
+    return true;
+  }
+
+private:
+  std::mutex mutex;
+  std::deque<Range> q;
+};
+
+struct Link {
+  uint32_t parent;
+  Action action;
+};
+
+struct Violation {
+  uint8_t invariant;
+  uint32_t parent;
+  Action action;
+};
+
+struct WorkerResult {
+  std::vector<Node> next;
+  std::vector<Violation> violations;
+  uint64_t expanded = 0;
+  uint64_t stolen = 0;
+};
+
+class Explorer {
+public:
+  int numThreads;
+  std::vector<std::vector<Link>> links;  // 各深さのノードの親 (反例の復元用)
+  std::vector<Node> frontier;
+  VisitedSet visited;
+  bool found[NUM_INVARIANTS] = {};
+  std::vector<Action> counterexample[NUM_INVARIANTS];
+  uint64_t expanded = 0;
+  uint64_t stolen = 0;
+  bool verbose = true;
+
+  Explorer(int numThreads, const Node &root) : numThreads(numThreads) {
+    links.push_back({ { root.parent, root.action } });
+    frontier.push_back(root);
+    visited.insert(stateKey(root));
+  }
+
+  void run(int maxDepth) {
+    for (int depth = 1; depth <= maxDepth && !frontier.empty(); depth++) {
+      expandLevel();
+      if (!verbose) continue;
+      printf("  depth %2d: %8zu new states, %9zu visited\n", depth, frontier.size(), visited.size());
+      fflush(stdout);
+    }
+  }
+
+private:
+  static constexpr uint32_t CHUNK_SIZE = 32;
+
+  std::vector<Action> pathTo(size_t level, uint32_t index) const {
+    std::vector<Action> path;
+    while (level > 0) {
+      const Link &l = links[level][index];
+      path.push_back(l.action);
+      index = l.parent;
+      level--;
+    }
+    return std::vector<Action>(path.rbegin(), path.rend());
+  }
+
+  void expandLevel() {
+    std::vector<WorkQueue> queues(numThreads);
+    uint32_t numChunks = 0;
+    for (uint32_t i = 0; i < frontier.size(); i += CHUNK_SIZE) {
+      uint32_t end = i + CHUNK_SIZE;
+      if (end > frontier.size()) end = frontier.size();
+      queues[numChunks++ % numThreads].push({ i, end });
+    }
+
+    std::vector<WorkerResult> results(numThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.emplace_back([&, t]() {
+        worker(t, frontier, queues, results[t]);
+      });
+    }
+    for (auto &th : threads) th.join();
+
+    // 反例は最短のものの中で入力系列が辞書順最小のものを選ぶ
+    size_t level = links.size() - 1;
+    for (auto &r : results) {
+      expanded += r.expanded;
+      stolen += r.stolen;
+      for (auto &v : r.violations) {
+        if (found[v.invariant] && counterexample[v.invariant].size() < level + 1) continue;
+        std::vector<Action> path = pathTo(level, v.parent);
+        path.push_back(v.action);
+        if (!found[v.invariant] || path < counterexample[v.invariant]) {
+          counterexample[v.invariant] = path;
+        }
+      }
+    }
+    for (int i = 0; i < NUM_INVARIANTS; i++) {
+      if (!counterexample[i].empty()) found[i] = true;
+    }
+
+    std::vector<Node> next;
+    std::vector<Link> nextLinks;
+    for (auto &r : results) {
+      for (auto &n : r.next) {
+        nextLinks.push_back({ n.parent, n.action });
+      }
+      next.insert(next.end(), r.next.begin(), r.next.end());
+    }
+    links.push_back(std::move(nextLinks));
+    frontier = std::move(next);
+  }
+
+  void worker(int id, const std::vector<Node> &frontier, std::vector<WorkQueue> &queues, WorkerResult &res) {
+    std::vector<TraceEntry> events;
+    WorkQueue::Range range;
+    for (;;) {
+      if (!queues[id].pop(&range)) {
+        bool ok = false;
+        for (int i = 1; i < numThreads && !ok; i++) {
+          ok = queues[(id + i) % numThreads].steal(&range);
+        }
+        if (!ok) break;
+        res.stolen++;
+      }
+      for (uint32_t i = range.begin; i < range.end; i++) {
+        for (int a = 0; a < NUM_ACTIONS; a++) {
+          Node child = frontier[i];
+          child.parent = i;
+          child.action = (Action)a;
+          uint32_t violated = applyAction(child.fw, child.mon, child.action, events);
+          res.expanded++;
+          for (uint8_t inv = 0; inv < NUM_INVARIANTS; inv++) {
+            if ((violated >> inv) & 1) {
+              res.violations.push_back({ inv, i, child.action });
+            }
+          }
+          if (visited.insert(stateKey(child))) {
+            res.next.push_back(child);
+          }
+        }
+      }
+    }
+  }
+};
+
+// 反例を再生して表示する
+static void printTrace(const Node &root, const std::vector<Action> &path) {
+  FirmwareModel fw = root.fw;
+  Monitor mon = root.mon;
+  std::vector<TraceEntry> events;
+  for (size_t i = 0; i < path.size(); i++) {
+    uint64_t t0 = fw.tick;
+    applyAction(fw, mon, path[i], events);
+    printf("    %2zu: %-20s t=%6llu..%6llu", i + 1, actionName(path[i]),
+           (unsigned long long)t0, (unsigned long long)fw.tick);
+    for (auto &e : events) {
+      printf(" %s", eventName(e.event));
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char **argv) {
+  int maxDepth = (argc >= 2) ? atoi(argv[1]) : 16;
+  int numThreads = (argc >= 3) ? atoi(argv[2]) : std::thread::hardware_concurrency();
+  if (numThreads < 1) numThreads = 1;
+
+  static const XoshiroJumper jumper;
+  static constexpr uint32_t INITIAL_RNG_STATE[4] = { 0x12345678, 0x23456789, 0x34567890, 0x45678901 };
+
+  Node root;
+  root.fw.jumper = &jumper;
+  root.fw.setup(INITIAL_RNG_STATE);
+  root.parent = 0;
+  root.action = Action::RELEASE_1;
+
+  printf("Exploring up to depth %d with %d thread(s):\n", maxDepth, numThreads);
+  auto t0 = std::chrono::steady_clock::now();
+  Explorer ex(numThreads, root);
+  ex.run(maxDepth);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  printf("  %llu transitions, %llu chunks stolen, %.2f sec\n",
+         (unsigned long long)ex.expanded, (unsigned long long)ex.stolen, elapsed);
+
+  int numFail = 0;
+  for (int i = 0; i < NUM_INVARIANTS; i++) {
+    const Invariant &inv = INVARIANTS[i];
+    bool ok = (ex.found[i] == inv.expectViolation);
+    if (ex.found[i]) {
+      printf("%s: %s (counterexample, %zu steps)\n", ok ? "OK  " : "FAIL", inv.name, ex.counterexample[i].size());
+      printTrace(root, ex.counterexample[i]);
+    } else {
+      printf("%s: %s (%s)\n", ok ? "OK  " : "FAIL", inv.name,
+             inv.expectViolation ? "not reached, increase depth" : "holds");
+    }
+    if (!ok) numFail++;
+  }
+
+  // 並列化で探索結果が変わらないこと (1 スレッドでの探索と比較する)
+  if (numThreads > 1) {
+    Explorer ref(1, root);
+    ref.verbose = false;
+    ref.run(maxDepth);
+    bool same = (ref.visited.size() == ex.visited.size()) && (ref.expanded == ex.expanded);
+    for (int i = 0; i < NUM_INVARIANTS; i++) {
+      // 同じ状態に到達する経路のどれが先に登録されるかは実行ごとに変わるので、反例は長さだけ比べる
+      same &= (ref.found[i] == ex.found[i]) && (ref.counterexample[i].size() == ex.counterexample[i].size());
+    }
+    printf("%s: %d thread(s) agree with 1 thread (%zu visited)\n", same ? "OK  " : "FAIL", numThreads,
+           ref.visited.size());
+    if (!same) numFail++;
+  }
+
+  if (numFail == 0) {
+    printf("Test passed!\n");
+    return 0;
+  } else {
+    printf("Test failed!\n");
+    return 1;
+  }
+}
@@ -0,0 +1,58 @@
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "xoshiro128plusplus.hpp"
+#include "xoroshiro64star.hpp"
+#include "pcg32x16.hpp"
+#include "xorshift16.hpp"
+
+//------------------------------------------------------------------------
+// ATtiny85 での乱数生成器のコスト測定用プログラム (make avr-cost)
+//
+// -DRNG=<クラス名> で生成器を選ぶ。next() を NUM_DRAWS 回呼ぶ区間の
+// 前後で GPIOR0 に 1, 2 を書き、シミュレータ (cycles.c) がその間の
+// サイクル数を数える。NullRng のビルドをベースラインとして差し引く。
+//------------------------------------------------------------------------
+
+#ifndef RNG
+#error "define RNG"
+#endif
+
+#ifndef NUM_DRAWS
+#define NUM_DRAWS 256
+#endif
+
+// ベースライン (呼び出しと結果の格納のみ)
+class NullRng {
+public:
+  using result_type = uint8_t;
+
+  uint8_t state[1] = { 0 };
+  static constexpr uint8_t STATE_BYTES = sizeof(state);
+
+  uint8_t next(void) {
+    return state[0];
+  }
+};
+
+static RNG rng;
+static volatile uint32_t sink;
+
+static __attribute__((noinline)) void draw() {
+  sink = rng.next();
+}
+
+int main() {
+  GPIOR0 = 1;
+  for (uint16_t i = 0; i < NUM_DRAWS; i++) {
+    draw();
+  }
+  GPIOR0 = 2;
+
+  // 割り込み禁止のスリープでシミュレータが終了する
+  cli();
+  sleep_enable();
+  sleep_cpu();
+  for (;;) {}
+}
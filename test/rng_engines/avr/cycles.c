@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+
+//------------------------------------------------------------------------
+// bench.cpp の ELF を simavr の ATtiny85 で実行し、GPIOR0 に 1 が
+// 書かれてから 2 が書かれるまでのサイクル数を表示する
+//------------------------------------------------------------------------
+
+// GPIOR0 のデータ空間アドレス (I/O アドレス 0x11)
+#define GPIOR0_ADDR 0x31
+
+static avr_cycle_count_t marks[3];
+static uint8_t marked;
+
+static void onGpior0Write(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+  (void)addr;
+  (void)param;
+  if (v < 3) {
+    marks[v] = avr->cycle;
+    marked |= 1 << v;
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <elf>\n", argv[0]);
+    return 1;
+  }
+
+  elf_firmware_t fw;
+  memset(&fw, 0, sizeof(fw));
+  if (elf_read_firmware(argv[1], &fw) != 0) {
+    fprintf(stderr, "%s: failed to read\n", argv[1]);
+    return 1;
+  }
+
+  avr_t *avr = avr_make_mcu_by_name("attiny85");
+  if (!avr) {
+    fprintf(stderr, "attiny85 is not supported by this simavr\n");
+    return 1;
+  }
+  avr_init(avr);
+  avr->frequency = 8000000;
+  avr_load_firmware(avr, &fw);
+  avr_register_io_write(avr, GPIOR0_ADDR, onGpior0Write, NULL);
+
+  int state;
+  do {
+    state = avr_run(avr);
+  } while (state != cpu_Done && state != cpu_Crashed);
+
+  if (state == cpu_Crashed || marked != ((1 << 1) | (1 << 2))) {
+    fprintf(stderr, "%s: markers not reached\n", argv[1]);
+    return 1;
+  }
+  printf("%llu\n", (unsigned long long)(marks[2] - marks[1]));
+  return 0;
+}
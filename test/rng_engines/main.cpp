@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "xoshiro128plusplus.hpp"
+#include "xoroshiro64star.hpp"
+#include "pcg32x16.hpp"
+#include "xorshift16.hpp"
+#include "dice_core.hpp"
+
+//------------------------------------------------------------------------
+// DiceCore 用乱数生成器の比較
+//
+// - 参照実装・公開されている出力例との一致
+// - 状態バイト列の保存/復元 (loadRngState/saveRngState 相当)
+// - サイコロの目 (next() % 6) の統計的な品質
+// - RAM 使用量とホストでの実行時間
+// - ATtiny85 での Flash 増分とサイクル数 (make avr-cost の結果があれば表示)
+//------------------------------------------------------------------------
+
+// 参照実装
+namespace ref {
+
+static inline uint32_t rotl(const uint32_t x, int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+static uint32_t xoroshiro64star(uint32_t *s) {
+  const uint32_t s0 = s[0];
+  uint32_t s1 = s[1];
+  const uint32_t result = s0 * 0x9E3779BB;
+  s1 ^= s0;
+  s[0] = rotl(s0, 26) ^ s1 ^ (s1 << 9);
+  s[1] = rotl(s1, 13);
+  return result;
+}
+
+// PCG の LCG と XSH-RR 出力 (pcg-c の pcg_output_xsh_rr_* を状態/出力幅で一般化したもの)
+// シフト量は幅から決まるので、公開されている pcg32 (64bit 状態, 32bit 出力) の
+// 出力例で確かめた式をそのまま 32bit 状態, 16bit 出力に使える。
+template<typename STATE_T, typename OUT_T>
+struct PcgXshRr {
+  static constexpr int STATE_BITS = sizeof(STATE_T) * 8;
+  static constexpr int OUT_BITS = sizeof(OUT_T) * 8;
+  static constexpr int OP_BITS = (OUT_BITS == 32) ? 5 : (OUT_BITS == 16) ? 4 : 3;  // log2(OUT_BITS)
+  static constexpr int XSHIFT = (OP_BITS + OUT_BITS) / 2;
+  static constexpr int BOTTOM_SPARE = STATE_BITS - OUT_BITS - OP_BITS;
+
+  STATE_T state;
+  STATE_T mul;
+  STATE_T inc;
+
+  // pcg_*_srandom_r 相当
+  void seed(STATE_T initState) {
+    state = 0;
+    next();
+    state += initState;
+    next();
+  }
+
+  OUT_T next() {
+    STATE_T old = state;
+    state = old * mul + inc;
+    OUT_T x = (OUT_T)(((old >> XSHIFT) ^ old) >> BOTTOM_SPARE);
+    unsigned rot = (unsigned)(old >> (STATE_BITS - OP_BITS));
+    return (OUT_T)((x >> rot) | (x << ((-rot) & (OUT_BITS - 1))));
+  }
+};
+
+// pcg-c の既定の定数
+static constexpr uint64_t PCG_DEFAULT_MULTIPLIER_64 = 6364136223846793005ull;
+static constexpr uint32_t PCG_DEFAULT_MULTIPLIER_32 = 747796405u;
+static constexpr uint32_t PCG_DEFAULT_INCREMENT_32 = 2891336453u;
+
+// pcg32-demo (pcg32_srandom_r(&rng, 42u, 54u)) の最初の 6 出力
+static constexpr uint32_t PCG32_DEMO_OUTPUT[] = {
+  0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e,
+};
+
+// GF(2) 上の 16x16 行列 (col[i] は入力の bit i が寄与する出力)
+// xorshift は T = (I + L^c)(I + R^b)(I + L^a) と書ける (Marsaglia, 2003)
+struct Mat16 {
+  uint16_t col[16];
+
+  uint16_t apply(uint16_t v) const {
+    uint16_t y = 0;
+    for (int i = 0; i < 16; i++) {
+      if ((v >> i) & 1) y ^= col[i];
+    }
+    return y;
+  }
+
+  Mat16 operator*(const Mat16 &b) const {
+    Mat16 m;
+    for (int i = 0; i < 16; i++) m.col[i] = apply(b.col[i]);
+    return m;
+  }
+
+  bool operator==(const Mat16 &b) const {
+    return memcmp(col, b.col, sizeof(col)) == 0;
+  }
+
+  static Mat16 identity() {
+    Mat16 m;
+    for (int i = 0; i < 16; i++) m.col[i] = 1 << i;
+    return m;
+  }
+
+  // I + L^k (左シフト) / I + R^k (右シフト)
+  static Mat16 shiftXor(int k) {
+    Mat16 m = identity();
+    for (int i = 0; i < 16; i++) {
+      int j = i + k;
+      if (0 <= j && j < 16) m.col[i] ^= 1 << j;
+    }
+    return m;
+  }
+
+  Mat16 pow(uint32_t n) const {
+    Mat16 r = identity(), b = *this;
+    for (; n; n >>= 1) {
+      if (n & 1) r = r * b;
+      b = b * b;
+    }
+    return r;
+  }
+};
+
+// xorshift16 (7, 9, 8) の遷移行列
+static Mat16 xorshift16Matrix() {
+  return Mat16::shiftXor(8) * Mat16::shiftXor(-9) * Mat16::shiftXor(7);
+}
+
+}
+
+static constexpr const char *AVR_COST_FILE = "avr_cost.tsv";
+
+static int numFail = 0;
+
+static void check(bool ok, const char *name, const char *what) {
+  if (!ok) {
+    printf("  %s: %s FAILED\n", name, what);
+    numFail++;
+  }
+}
+
+// 状態バイト列を別のインスタンスに移して同じ系列になること
+template<typename RNG>
+static bool checkStateRoundTrip() {
+  DiceCore<RNG> a, b;
+  for (int i = 0; i < 100; i++) a.rng.next();
+  uint8_t sizeA = 0, sizeB = 0;
+  uint8_t *pa = a.getRngStatePtr(&sizeA);
+  uint8_t *pb = b.getRngStatePtr(&sizeB);
+  if (sizeA != RNG::STATE_BYTES || sizeB != RNG::STATE_BYTES) return false;
+  memcpy(pb, pa, sizeA);
+  for (int i = 0; i < 1000; i++) {
+    if (a.rng.next() != b.rng.next()) return false;
+  }
+  return true;
+}
+
+// 周期 (上限 limit まで)
+template<typename RNG>
+static uint64_t measurePeriod(uint64_t limit) {
+  RNG rng;
+  uint8_t start[RNG::STATE_BYTES];
+  memcpy(start, rng.state, sizeof(start));
+  for (uint64_t i = 1; i <= limit; i++) {
+    rng.next();
+    if (memcmp(start, rng.state, sizeof(start)) == 0) return i;
+  }
+  return 0;
+}
+
+struct Quality {
+  double chi2Face;   // 目の頻度 (自由度 5)
+  double chi2Pair;   // 連続する 2 回の目の組 (自由度 35)
+  double chi2Low8;   // 出力の下位 8bit の頻度 (自由度 255)
+  double nsPerDraw;  // ホストでの 1 回あたりの時間
+};
+
+static double chi2(const std::vector<uint64_t> &count, uint64_t total) {
+  double expected = (double)total / count.size();
+  double sum = 0;
+  for (uint64_t c : count) {
+    double d = c - expected;
+    sum += d * d / expected;
+  }
+  return sum;
+}
+
+template<typename RNG>
+static Quality measureQuality(uint64_t n) {
+  Quality q;
+  RNG rng;
+  std::vector<uint64_t> face(6), pair(36), low8(256);
+  uint8_t prev = 0;
+  for (uint64_t i = 0; i < n; i++) {
+    typename RNG::result_type r = rng.next();
+    uint8_t f = r % DiceCore<RNG>::PERIOD;
+    face[f]++;
+    if (i & 1) pair[prev * 6 + f]++;
+    prev = f;
+    low8[r & 0xff]++;
+  }
+  q.chi2Face = chi2(face, n);
+  q.chi2Pair = chi2(pair, n / 2);
+  q.chi2Low8 = chi2(low8, n);
+
+  RNG bench;
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  uint32_t acc = 0;
+  for (uint64_t i = 0; i < n; i++) acc += bench.next();
+  sink = acc;
+  (void)sink;
+  q.nsPerDraw = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+  return q;
+}
+
+// make avr-cost の結果 (エンジン名, Flash 増分 [B], 1 回あたりのサイクル数)
+struct AvrCost {
+  char name[32];
+  int flash;
+  double cycles;
+};
+
+static std::vector<AvrCost> avrCosts;
+
+static void loadAvrCosts(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) return;
+  AvrCost c;
+  while (fscanf(fp, "%31s %d %lf", c.name, &c.flash, &c.cycles) == 3) {
+    avrCosts.push_back(c);
+  }
+  fclose(fp);
+}
+
+static const AvrCost *findAvrCost(const char *name) {
+  for (auto &c : avrCosts) {
+    if (strcmp(c.name, name) == 0) return &c;
+  }
+  return nullptr;
+}
+
+// 有意水準 0.1% の棄却限界 (両側: 偏りすぎも揃いすぎも棄却)
+struct Chi2Range {
+  double lo;
+  double hi;
+  const char *mark(double x) const {
+    return (lo < x && x < hi) ? " " : "*";
+  }
+};
+static constexpr Chi2Range CHI2_CRIT_5 = { 0.21, 20.52 };
+static constexpr Chi2Range CHI2_CRIT_35 = { 14.61, 66.62 };
+static constexpr Chi2Range CHI2_CRIT_255 = { 190.8, 330.52 };
+
+template<typename RNG>
+static void report(const char *name, uint64_t period) {
+  constexpr uint64_t N = 12000000;
+  Quality q = measureQuality<RNG>(N);
+  char periodStr[32];
+  if (period) {
+    snprintf(periodStr, sizeof(periodStr), "%llu", (unsigned long long)period);
+  } else {
+    snprintf(periodStr, sizeof(periodStr), "2^%d-1", RNG::STATE_BYTES * 8);
+  }
+  char flashStr[16] = "-", cyclesStr[16] = "-";
+  if (const AvrCost *c = findAvrCost(name)) {
+    snprintf(flashStr, sizeof(flashStr), "%d", c->flash);
+    snprintf(cyclesStr, sizeof(cyclesStr), "%.1f", c->cycles);
+  }
+  printf("%-18s %4u %3d %6s %7s %8.2f %10s %7.1f%s %7.1f%s %7.1f%s\n", name, (unsigned)RNG::STATE_BYTES,
+         (int)sizeof(typename RNG::result_type) * 8, flashStr, cyclesStr, q.nsPerDraw, periodStr,
+         q.chi2Face, CHI2_CRIT_5.mark(q.chi2Face),
+         q.chi2Pair, CHI2_CRIT_35.mark(q.chi2Pair),
+         q.chi2Low8, CHI2_CRIT_255.mark(q.chi2Low8));
+}
+
+int main(int argc, char **argv) {
+  // 参照実装との一致
+  {
+    Xoroshiro64star rng;
+    uint32_t s[2];
+    memcpy(s, rng.state, sizeof(s));
+    bool ok = true;
+    for (int i = 0; i < 0x100000; i++) ok &= (rng.next() == ref::xoroshiro64star(s));
+    check(ok, "Xoroshiro64star", "reference");
+  }
+  {
+    // 一般化した XSH-RR を pcg32 の公開されている出力例で確かめる
+    ref::PcgXshRr<uint64_t, uint32_t> pcg32 = { 0, ref::PCG_DEFAULT_MULTIPLIER_64, (54ull << 1) | 1 };
+    pcg32.seed(42);
+    bool ok = true;
+    for (uint32_t expected : ref::PCG32_DEMO_OUTPUT) ok &= (pcg32.next() == expected);
+    check(ok, "PcgXshRr<64,32>", "pcg32-demo output");
+  }
+  {
+    // pcg_oneseq_32_xsh_rr_16 (pcg-c の既定の定数)
+    Pcg32x16 rng;
+    ref::PcgXshRr<uint32_t, uint16_t> s = { rng.state[0], ref::PCG_DEFAULT_MULTIPLIER_32, ref::PCG_DEFAULT_INCREMENT_32 };
+    bool ok = true;
+    for (int i = 0; i < 0x100000; i++) ok &= (rng.next() == s.next());
+    check(ok, "Pcg32x16", "reference");
+  }
+  {
+    // シフト演算ではなく遷移行列で進めた系列と一致すること
+    ref::Mat16 t = ref::xorshift16Matrix();
+    Xorshift16 rng;
+    uint16_t s = rng.state[0];
+    bool ok = true;
+    for (int i = 0; i < 0x100000; i++) {
+      s = t.apply(s);
+      ok &= (rng.next() == s);
+    }
+    check(ok, "Xorshift16", "reference");
+
+    // 遷移行列の位数が 2^16-1 (= 3 * 5 * 17 * 257) なら非ゼロの全状態で周期が最大
+    ok = (t.pow(65535) == ref::Mat16::identity());
+    for (uint32_t p : { 3, 5, 17, 257 }) ok &= !(t.pow(65535 / p) == ref::Mat16::identity());
+    check(ok, "Xorshift16", "full period (matrix order)");
+  }
+
+  // 状態の保存/復元
+  check(checkStateRoundTrip<Xoshiro128plusplus>(), "Xoshiro128plusplus", "state round trip");
+  check(checkStateRoundTrip<Xoroshiro64star>(), "Xoroshiro64star", "state round trip");
+  check(checkStateRoundTrip<Pcg32x16>(), "Pcg32x16", "state round trip");
+  check(checkStateRoundTrip<Xorshift16>(), "Xorshift16", "state round trip");
+
+  // 周期 (短いものだけ実測)
+  uint64_t xorshift16Period = measurePeriod<Xorshift16>(1 << 20);
+  check(xorshift16Period == 65535, "Xorshift16", "period");
+
+  // 比較表 (* は有意水準 0.1% で一様性を棄却)
+  // Flash/cycles は ATtiny85 (avr-gcc -Os) での NullRng との差
+  loadAvrCosts(AVR_COST_FILE);
+  printf("%-18s %4s %3s %6s %7s %8s %10s %8s %8s %8s\n", "engine", "RAM", "out", "Flash", "cycles", "ns(host)",
+         "period", "chi2/d6", "chi2/2d6", "chi2/lo8");
+  printf("%-18s %4s %3s %6s %7s %8s %10s %8s %8s %8s\n", "", "[B]", "[b]", "[B]", "/draw", "", "", "(df=5)",
+         "(df=35)", "(df=255)");
+  report<Xoshiro128plusplus>("Xoshiro128plusplus", 0);
+  report<Xoroshiro64star>("Xoroshiro64star", 0);
+  report<Pcg32x16>("Pcg32x16", (uint64_t)1 << 32);
+  report<Xorshift16>("Xorshift16", xorshift16Period);
+  if (avrCosts.empty()) {
+    printf("No %s: run 'make avr-cost' (needs avr-gcc and simavr) to fill in Flash and cycles.\n", AVR_COST_FILE);
+  }
+
+  if (numFail == 0) {
+    printf("Test passed!\n");
+    return 0;
+  } else {
+    printf("Test failed!\n");
+    return 1;
+  }
+}
@@ -0,0 +1,387 @@
+#pragma once
+
+//------------------------------------------------------------------------
+// shapodice.ino の setup()/loop() をホスト上で再現するモデル
+//
+// DiceCore/DiceLeds/Button はファームウェアのヘッダをそのまま使い、
+// loop() 1 回分を step() で 1 tick として実行する。
+// quietTicks()/skip() は「何もイベントが起きない区間」を閉じた式で進める。
+// サウンドは Timer1 割り込みで演奏され loop() の状態に影響しないので扱わない。
+//------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <type_traits>
+#include <Arduino.h>
+#include "dice_core.hpp"
+#include "dice_leds.hpp"
+#include "button.hpp"
+#include "shapodice_config.hpp"
+#include "xoshiro_jump.hpp"
+
+namespace sim {
+
+// ポート番号・タイミング等の設定値は shapodice_config.hpp をファームウェアと共有する
+
+// 乱数のジャンプ (xoshiro_jump.hpp) は Xoshiro128plusplus 専用
+static_assert(std::is_same<DiceRng, Xoshiro128plusplus>::value, "FirmwareModel assumes DiceRng is Xoshiro128plusplus");
+
+// 観測可能なイベント
+enum class SimEvent : uint8_t {
+  STARTED_UP,
+  BUTTON_DOWN,
+  BUTTON_UP,
+  ROLL,
+  STOP,
+  BATTERY_CHECK,
+  POWER_DOWN,
+  WAKE_UP,
+};
+
+struct TraceEntry {
+  uint64_t tick;
+  SimEvent event;
+  uint16_t value;
+
+  bool operator==(const TraceEntry &other) const {
+    return tick == other.tick && event == other.event && value == other.value;
+  }
+};
+
+class FirmwareModel {
+public:
+  DiceCore<DiceRng> dice;
+  DiceLeds<LED_PORT_X, LED_PORT_Y, LED_PORT_Z> leds;
+  Button<BUTTON_PORT> button;
+
+  uint8_t startupTimerMs = STARTUP_DELAY_MS;
+  uint16_t milliSecCounter = 0;
+  uint8_t powerDownTimerSec = POWER_DOWN_DELAY_SEC;
+  uint8_t batteryCheckTimerSec = 0;
+  bool lowBattery = false;
+
+  // パワーダウン中か否か
+  bool sleeping = false;
+
+  // パワーダウンした loop() の pulse1sec (起床後の処理で使う)
+  bool sleepPulse = false;
+
+  // EEPROM に保存された乱数生成器の状態
+  uint32_t savedRngState[4] = { 0, 0, 0, 0 };
+
+  // 入力: バッテリーの ADC 値 (analogRead の戻り値)
+  uint16_t batteryAdc = 0;
+
+  // 仮想時刻 (loop() の実行回数)
+  uint64_t tick = 0;
+
+  // イベントの記録先 (nullptr なら記録しない)
+  std::vector<TraceEntry> *trace = nullptr;
+
+  const XoshiroJumper *jumper = nullptr;
+
+  // setup() 相当
+  void setup(const uint32_t *eepromRngState) {
+    startup();
+    leds.put(0);
+    memcpy(dice.rng.state, eepromRngState, sizeof(dice.rng.state));
+    if ((dice.rng.state[0] | dice.rng.state[1] | dice.rng.state[2] | dice.rng.state[3]) == 0) {
+      uint8_t *p = (uint8_t *)dice.rng.state;
+      for (uint8_t i = 0; i < sizeof(dice.rng.state); i++) {
+        p[i] = i;
+      }
+    }
+    dice.rng.next();
+    memcpy(savedRngState, dice.rng.state, sizeof(savedRngState));
+  }
+
+  // loop() 1 回分の実行
+  void step(bool pressed) {
+    PINB = pressed ? (uint8_t)~(1 << BUTTON_PORT) : 0xff;
+
+    if (sleeping) {
+      // パワーダウン中はボタン押下で起床するまで何もしない
+      if (pressed) {
+        sleeping = false;
+        record(SimEvent::WAKE_UP, 0);
+        startup();
+        afterPowerDownControl(sleepPulse);
+      }
+      tick++;
+      return;
+    }
+
+    bool pulse1sec = (milliSecCounter == 0);
+    if (pulse1sec) {
+      milliSecCounter = 999;
+    } else {
+      milliSecCounter--;
+    }
+
+    if (powerDownTimerSec != 0) {
+      if (pulse1sec) {
+        powerDownTimerSec--;
+      }
+      afterPowerDownControl(pulse1sec);
+    } else {
+      // パワーダウン
+      memcpy(savedRngState, dice.rng.state, sizeof(savedRngState));
+      record(SimEvent::POWER_DOWN, 0);
+      sleeping = true;
+      sleepPulse = pulse1sec;
+    }
+    tick++;
+  }
+
+  // パワーダウン中の時間経過
+  void sleepFor(uint64_t n) {
+    tick += n;
+  }
+
+  // イベントが起きずに閉じた式で進められる tick 数を返す
+  // (入力 pressed はこの区間変化しないものとする)
+  uint32_t quietTicks(bool pressed) const {
+    if (sleeping) return 0;
+
+    // 次の tick で起きることが決まっている処理
+    if (powerDownTimerSec == 0 || batteryCheckTimerSec == 0) return 0;
+
+    // 秒パルス
+    uint32_t n = milliSecCounter;
+
+    // ボタンの入力が安定していること
+    uint8_t settledFilter = pressed ? 0xff : 0x00;
+    ButtonState settledState = pressed ? ButtonState::DOWN : ButtonState::UP;
+    if (button.filter != settledFilter || button.switchState != settledState) return 0;
+
+    // 起動直後の待ち時間の満了
+    if (startupTimerMs > 0 && !pressed) {
+      n = min32(n, startupTimerMs - 1);
+    }
+
+    // サイコロの ROLL/STOP
+    if (dice.rollingSpeed != 0) {
+      if (dice.buttonPressed) {
+        uint32_t inc = dice.rollingSpeed >> DiceCore<>::ROLLING_SPEED_PREC;
+        if (inc != 0) {
+          uint32_t k = (DiceCore<>::ROLLING_TIMER_PERIOD - dice.rollingTimer + inc - 1) / inc;
+          n = min32(n, k - 1);
+        }
+      } else {
+        n = min32(n, dice.rollingSpeed - 1);
+        n = min32(n, slowdownTicksToRoll() - 1);
+      }
+    }
+
+    // LED 点滅の切り替わり
+    if (leds.blinkCount) {
+      n = min32(n, leds.blinkTimer);
+    }
+
+    return n;
+  }
+
+  // quietTicks() 以下の n tick を閉じた式で進める
+  void skip(uint32_t n, bool pressed) {
+    if (n == 0) return;
+    tick += n;
+    milliSecCounter -= n;
+
+    if (startupTimerMs > 0) {
+      if (pressed) {
+        startupTimerMs = STARTUP_DELAY_MS;
+      } else {
+        startupTimerMs -= n;
+      }
+    }
+
+    if (pressed || dice.isRolling()) {
+      powerDownTimerSec = POWER_DOWN_DELAY_SEC;
+    }
+
+    if (!dice.buttonPressed) {
+      jumper->jump(dice.rng, n);
+    }
+    if (dice.rollingSpeed == 0) {
+      dice.rollingTimer = 0;
+    } else if (dice.buttonPressed) {
+      dice.rollingTimer += n * (dice.rollingSpeed >> DiceCore<>::ROLLING_SPEED_PREC);
+    } else {
+      uint16_t s = dice.rollingSpeed;
+      dice.rollingTimer += slowdownSum(s, n);
+      dice.rollingSpeed = s - n;
+    }
+
+    leds.scanIndex = (leds.scanIndex + n) % leds.NUM_ELEMENTS;
+    if (leds.blinkCount) {
+      leds.blinkTimer -= n;
+    }
+    leds.setUserLed(lowBattery && !(milliSecCounter & 0x200));
+  }
+
+  // 状態のハッシュ値 (ポートのレジスタは出力なので含めない)
+  uint64_t hash() const {
+    Fnv h;
+    mixControl(h);
+    for (int i = 0; i < 4; i++) h.mix(dice.rng.state[i]);
+    for (int i = 0; i < 4; i++) h.mix(savedRngState[i]);
+    h.mix(dice.number);
+    h.mix(leds.state);
+    h.mix(tick);
+    return h.value;
+  }
+
+  // 制御の流れに関わる状態のみのハッシュ値
+  // (乱数・出目・時刻は分岐に影響しないので除外する)
+  uint64_t controlHash() const {
+    Fnv h;
+    mixControl(h);
+    return h.value;
+  }
+
+private:
+  struct Fnv {
+    uint64_t value = 0xcbf29ce484222325ull;
+    void mix(uint64_t v) {
+      for (int i = 0; i < 8; i++) {
+        value ^= (v >> (i * 8)) & 0xff;
+        value *= 0x100000001b3ull;
+      }
+    }
+  };
+
+  void mixControl(Fnv &h) const {
+    h.mix(dice.buttonPressed);
+    h.mix(dice.rollingSpeed);
+    h.mix(dice.rollingTimer);
+    h.mix(leds.scanIndex);
+    h.mix(leds.blinkTimer);
+    h.mix(leds.blinkCount);
+    h.mix(leds.userLed);
+    h.mix(button.filter);
+    h.mix(button.isPressed);
+    h.mix((uint8_t)button.switchState);
+    h.mix(startupTimerMs);
+    h.mix(milliSecCounter);
+    h.mix(powerDownTimerSec);
+    h.mix(batteryCheckTimerSec);
+    h.mix(lowBattery);
+    h.mix(sleeping);
+    h.mix(sleepPulse);
+  }
+
+  static uint32_t min32(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+  }
+
+  void record(SimEvent event, uint16_t value) {
+    if (trace) trace->push_back({ tick, event, value });
+  }
+
+  // startup() 相当
+  void startup() {
+    startupTimerMs = STARTUP_DELAY_MS;
+    powerDownTimerSec = POWER_DOWN_DELAY_SEC;
+    batteryCheckTimerSec = 0;
+    milliSecCounter = 0;
+  }
+
+  // loop() のうち powerDownControl() より後の処理
+  void afterPowerDownControl(bool pulse1sec) {
+    batteryCheck(pulse1sec);
+
+    ButtonState btn = button.read();
+
+    if (startupTimerMs > 0) {
+      if (button.read() == ButtonState::UP) {
+        startupTimerMs--;
+        if (startupTimerMs == 0) {
+          record(SimEvent::STARTED_UP, 0);
+        }
+      } else {
+        startupTimerMs = STARTUP_DELAY_MS;
+      }
+    } else {
+      switch (btn) {
+        case ButtonState::DOWN_EDGE:
+          dice.startRolling();
+          leds.stopBlink();
+          record(SimEvent::BUTTON_DOWN, 0);
+          break;
+
+        case ButtonState::UP_EDGE:
+          dice.startSlowdown();
+          record(SimEvent::BUTTON_UP, dice.last());
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    if (btn != ButtonState::UP || dice.isRolling()) {
+      powerDownTimerSec = POWER_DOWN_DELAY_SEC;
+    }
+
+    auto evt = dice.update();
+    if (evt == DiceEvent::STOP) {
+      leds.startBlink();
+    }
+
+    if (evt != DiceEvent::NONE) {
+      leds.put(dice.last());
+      record(evt == DiceEvent::ROLL ? SimEvent::ROLL : SimEvent::STOP, dice.last());
+    }
+
+    leds.setUserLed(lowBattery && !(milliSecCounter & 0x200));
+    leds.update();
+  }
+
+  // batteryCheck() 相当
+  void batteryCheck(bool pulse1sec) {
+    if (batteryCheckTimerSec != 0) {
+      if (pulse1sec) {
+        batteryCheckTimerSec--;
+      }
+      return;
+    }
+    batteryCheckTimerSec = BATTERY_CHECK_INTERVAL_SEC;
+    lowBattery = batteryAdc >= LOW_BATTERY_THRESH_ADC;
+    record(SimEvent::BATTERY_CHECK, batteryAdc);
+  }
+
+  // sum_{x=0}^{m} floor(x / 4)
+  static uint32_t floorQuarterSum(int32_t m) {
+    if (m < 0) return 0;
+    uint32_t c = m + 1;
+    uint32_t q = c / 4;
+    uint32_t r = c % 4;
+    return 2 * q * (q - 1) + r * q;
+  }
+
+  // 減速中に j tick 進めたときのタイマー加算量の合計
+  static uint32_t slowdownSum(uint16_t speed, uint32_t j) {
+    static_assert(DiceCore<>::ROLLING_SPEED_PREC == 2, "slowdownSum() assumes ROLLING_SPEED_PREC == 2");
+    return floorQuarterSum((int32_t)speed - 1) - floorQuarterSum((int32_t)speed - 1 - (int32_t)j);
+  }
+
+  // 減速中に次の ROLL が起きる tick (1 始まり、起きなければ rollingSpeed)
+  uint32_t slowdownTicksToRoll() const {
+    uint16_t s = dice.rollingSpeed;
+    uint32_t need = DiceCore<>::ROLLING_TIMER_PERIOD - dice.rollingTimer;
+    if (s <= 1 || slowdownSum(s, s - 1) < need) return s;
+    uint32_t lo = 1, hi = s - 1;
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (slowdownSum(s, mid) >= need) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return lo;
+  }
+};
+
+}
@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "firmware_model.hpp"
+
+//------------------------------------------------------------------------
+// 離散イベント・時間スキップ型シミュレータ
+//
+// 長時間の利用シナリオ (ボタン操作とバッテリー電圧) を与え、
+// 1 tick ずつ loop() を回す参照実行と、イベント間を skip() で飛ばす
+// イベント駆動実行が同じ結果になることを確認する。
+//------------------------------------------------------------------------
+
+using namespace sim;
+
+static constexpr uint64_t TICKS_PER_SEC = 1000;
+static constexpr uint64_t TICKS_PER_DAY = 24 * 60 * 60 * TICKS_PER_SEC;
+
+// ボタン入力の変化点
+struct Edge {
+  uint64_t tick;
+  bool pressed;
+};
+
+struct Scenario {
+  std::vector<Edge> edges;
+  uint64_t endTick = 0;
+
+  // バッテリー電圧は 1 日あたり 20mV ずつ下がる
+  uint16_t batteryAdcAt(uint64_t tick) const {
+    uint32_t milliVolt = 3600 - (uint32_t)(tick * 20 / TICKS_PER_DAY);
+    return (uint32_t)(1.1 * 1024 * 1000) / milliVolt;
+  }
+};
+
+// 押下・開放時にチャタリングを付けてボタン入力を追加する
+static void addTransition(Scenario &sc, std::mt19937_64 &rnd, uint64_t tick, bool pressed) {
+  int bounces = rnd() % 4;
+  for (int i = 0; i < bounces; i++) {
+    sc.edges.push_back({ tick, pressed });
+    tick += 1 + rnd() % 2;
+    sc.edges.push_back({ tick, !pressed });
+    tick += 1 + rnd() % 2;
+  }
+  sc.edges.push_back({ tick, pressed });
+}
+
+// 1 日に何度か起こして何回か振る利用シナリオを生成する
+static Scenario makeScenario(uint64_t seed, int days, int sessionsPerDay) {
+  std::mt19937_64 rnd(seed);
+  Scenario sc;
+  sc.endTick = days * TICKS_PER_DAY;
+  uint64_t sessionInterval = TICKS_PER_DAY / sessionsPerDay;
+  for (uint64_t start = 0; start + sessionInterval <= sc.endTick; start += sessionInterval) {
+    uint64_t t = start + rnd() % (sessionInterval / 2);
+
+    // ボタンを押して起こす
+    addTransition(sc, rnd, t, true);
+    t += 100 + rnd() % 500;
+    addTransition(sc, rnd, t, false);
+    t += 200 + rnd() % 300;
+
+    // 何回か振る (点滅中に押すこともある)
+    int rolls = 1 + rnd() % 12;
+    for (int i = 0; i < rolls; i++) {
+      addTransition(sc, rnd, t, true);
+      t += 20 + rnd() % 3000;
+      addTransition(sc, rnd, t, false);
+      t += 500 + rnd() % 8000;
+    }
+  }
+  return sc;
+}
+
+struct RunResult {
+  std::vector<TraceEntry> trace;
+  std::vector<std::pair<uint64_t, uint64_t>> checkpoints;
+  uint64_t finalHash = 0;
+  uint64_t steps = 0;
+  uint64_t skips = 0;
+  double elapsedSec = 0;
+};
+
+static constexpr uint32_t INITIAL_RNG_STATE[4] = { 0x12345678, 0x23456789, 0x34567890, 0x45678901 };
+
+// 1 tick ずつ実行する
+static void runReference(const Scenario &sc, const XoshiroJumper &jumper, RunResult &res,
+                         const std::vector<std::pair<uint64_t, uint64_t>> *expected, int *numMismatch) {
+  FirmwareModel fw;
+  fw.trace = &res.trace;
+  fw.jumper = &jumper;
+  fw.setup(INITIAL_RNG_STATE);
+
+  auto t0 = std::chrono::steady_clock::now();
+  size_t edgeIndex = 0;
+  size_t cpIndex = 0;
+  bool pressed = false;
+  while (fw.tick < sc.endTick) {
+    while (edgeIndex < sc.edges.size() && sc.edges[edgeIndex].tick <= fw.tick) {
+      pressed = sc.edges[edgeIndex++].pressed;
+    }
+    fw.batteryAdc = sc.batteryAdcAt(fw.tick);
+    fw.step(pressed);
+    res.steps++;
+
+    // イベント駆動実行で step() した tick では状態が一致していること
+    if (expected && cpIndex < expected->size() && (*expected)[cpIndex].first == fw.tick) {
+      if ((*expected)[cpIndex].second != fw.hash()) {
+        if (*numMismatch < 10) {
+          printf("  state mismatch at tick %llu\n", (unsigned long long)fw.tick);
+        }
+        (*numMismatch)++;
+      }
+      cpIndex++;
+    }
+  }
+  res.elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  res.finalHash = fw.hash();
+}
+
+// イベントの無い区間を飛ばしながら実行する
+static void runEventDriven(const Scenario &sc, const XoshiroJumper &jumper, RunResult &res, bool keepCheckpoints) {
+  FirmwareModel fw;
+  fw.trace = &res.trace;
+  fw.jumper = &jumper;
+  fw.setup(INITIAL_RNG_STATE);
+
+  auto t0 = std::chrono::steady_clock::now();
+  size_t edgeIndex = 0;
+  bool pressed = false;
+  while (fw.tick < sc.endTick) {
+    while (edgeIndex < sc.edges.size() && sc.edges[edgeIndex].tick <= fw.tick) {
+      pressed = sc.edges[edgeIndex++].pressed;
+    }
+    uint64_t nextEdge = (edgeIndex < sc.edges.size()) ? sc.edges[edgeIndex].tick : sc.endTick;
+    if (nextEdge > sc.endTick) nextEdge = sc.endTick;
+
+    if (fw.sleeping && !pressed) {
+      // 次にボタンが押されるまで眠ったまま
+      fw.sleepFor(nextEdge - fw.tick);
+      res.skips++;
+      continue;
+    }
+
+    uint64_t n = fw.quietTicks(pressed);
+    if (n > nextEdge - fw.tick) n = nextEdge - fw.tick;
+    if (n > 0) {
+      fw.skip(n, pressed);
+      res.skips++;
+    } else {
+      fw.batteryAdc = sc.batteryAdcAt(fw.tick);
+      fw.step(pressed);
+      res.steps++;
+      if (keepCheckpoints) {
+        res.checkpoints.push_back({ fw.tick, fw.hash() });
+      }
+    }
+  }
+  res.elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  res.finalHash = fw.hash();
+}
+
+static int countEvents(const std::vector<TraceEntry> &trace, SimEvent evt) {
+  int n = 0;
+  for (auto &e : trace) {
+    if (e.event == evt) n++;
+  }
+  return n;
+}
+
+int main(int argc, char **argv) {
+  XoshiroJumper jumper;
+  int numFail = 0;
+
+  // RNG ジャンプが next() の繰り返しと一致すること
+  {
+    Xoshiro128plusplus a, b;
+    memcpy(a.state, INITIAL_RNG_STATE, sizeof(a.state));
+    memcpy(b.state, INITIAL_RNG_STATE, sizeof(b.state));
+    const uint32_t steps[] = { 1, 2, 3, 100, 4095, 65536, 1000003 };
+    for (uint32_t n : steps) {
+      for (uint32_t i = 0; i < n; i++) a.next();
+      jumper.jump(b, n);
+      if (memcmp(a.state, b.state, sizeof(a.state)) != 0) {
+        printf("RNG jump mismatch: n=%u\n", n);
+        numFail++;
+      }
+    }
+  }
+
+  // 参照実行との等価性
+  {
+    Scenario sc = makeScenario(1, 1, 48);
+    RunResult ev, ref;
+    runEventDriven(sc, jumper, ev, true);
+    int numMismatch = 0;
+    runReference(sc, jumper, ref, &ev.checkpoints, &numMismatch);
+
+    bool traceMatch = (ev.trace == ref.trace);
+    bool finalMatch = (ev.finalHash == ref.finalHash);
+    printf("Equivalence (1 day, %zu input edges):\n", sc.edges.size());
+    printf("  reference   : %llu steps, %.3f sec\n", (unsigned long long)ref.steps, ref.elapsedSec);
+    printf("  event-driven: %llu steps + %llu skips, %.3f sec\n",
+           (unsigned long long)ev.steps, (unsigned long long)ev.skips, ev.elapsedSec);
+    printf("  trace: %zu entries (%s), checkpoints: %zu (%d mismatch), final state: %s\n",
+           ev.trace.size(), traceMatch ? "match" : "MISMATCH",
+           ev.checkpoints.size(), numMismatch, finalMatch ? "match" : "MISMATCH");
+    if (!traceMatch || !finalMatch || numMismatch != 0) numFail++;
+    if (countEvents(ev.trace, SimEvent::STOP) == 0 || countEvents(ev.trace, SimEvent::POWER_DOWN) == 0) {
+      printf("  scenario did not exercise rolls and power-downs\n");
+      numFail++;
+    }
+  }
+
+  // 長期間の利用
+  {
+    constexpr int DAYS = 30;
+    Scenario sc = makeScenario(2, DAYS, 48);
+    RunResult ev;
+    runEventDriven(sc, jumper, ev, false);
+    printf("Long run (%d days, %zu input edges):\n", DAYS, sc.edges.size());
+    printf("  event-driven: %llu steps + %llu skips, %.3f sec (%.0f virtual days/sec)\n",
+           (unsigned long long)ev.steps, (unsigned long long)ev.skips, ev.elapsedSec, DAYS / ev.elapsedSec);
+    printf("  rolls: %d, stops: %d, power-downs: %d, battery checks: %d\n",
+           countEvents(ev.trace, SimEvent::ROLL), countEvents(ev.trace, SimEvent::STOP),
+           countEvents(ev.trace, SimEvent::POWER_DOWN), countEvents(ev.trace, SimEvent::BATTERY_CHECK));
+  }
+
+  if (numFail == 0) {
+    printf("Test passed!\n");
+    return 0;
+  } else {
+    printf("Test failed!\n");
+    return 1;
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "xoshiro128plusplus.hpp"
+
+//------------------------------------------------------------------------
+// xoshiro128++ の任意ステップ数ジャンプ
+//
+// xoshiro128++ の状態遷移は GF(2) 上の線形写像なので、遷移行列 M の
+// 2 の冪乗 M^(2^k) を事前計算しておけば、n 回の next() と等価な状態を
+// n のビット数回の行列ベクトル積で求められる。
+//------------------------------------------------------------------------
+
+class XoshiroJumper {
+public:
+  static constexpr int STATE_BITS = 128;
+  static constexpr int STATE_WORDS = 4;
+  static constexpr int MAX_LOG2 = 64;
+
+  struct Matrix {
+    // 列ベクトル: 単位ベクトル e_i を写した結果
+    uint32_t col[STATE_BITS][STATE_WORDS];
+  };
+
+  // M^(2^k)
+  Matrix pow2[MAX_LOG2];
+
+  XoshiroJumper() {
+    // M: 単位ベクトルを 1 ステップ進めたものを列とする
+    for (int i = 0; i < STATE_BITS; i++) {
+      Xoshiro128plusplus rng;
+      memset(rng.state, 0, sizeof(rng.state));
+      rng.state[i / 32] = (uint32_t)1 << (i % 32);
+      rng.next();
+      memcpy(pow2[0].col[i], rng.state, sizeof(rng.state));
+    }
+    // M^(2^k) = M^(2^(k-1)) * M^(2^(k-1))
+    for (int k = 1; k < MAX_LOG2; k++) {
+      for (int i = 0; i < STATE_BITS; i++) {
+        apply(pow2[k - 1], pow2[k - 1].col[i], pow2[k].col[i]);
+      }
+    }
+  }
+
+  // next() を n 回呼んだのと同じ状態に進める
+  void jump(Xoshiro128plusplus &rng, uint64_t n) const {
+    for (int k = 0; n != 0; k++, n >>= 1) {
+      if (n & 1) {
+        uint32_t tmp[STATE_WORDS];
+        apply(pow2[k], rng.state, tmp);
+        memcpy(rng.state, tmp, sizeof(tmp));
+      }
+    }
+  }
+
+private:
+  static void apply(const Matrix &m, const uint32_t *in, uint32_t *out) {
+    uint32_t acc[STATE_WORDS] = { 0, 0, 0, 0 };
+    for (int w = 0; w < STATE_WORDS; w++) {
+      uint32_t bits = in[w];
+      while (bits) {
+        int b = __builtin_ctz(bits);
+        bits &= bits - 1;
+        const uint32_t *c = m.col[w * 32 + b];
+        acc[0] ^= c[0];
+        acc[1] ^= c[1];
+        acc[2] ^= c[2];
+        acc[3] ^= c[3];
+      }
+    }
+    memcpy(out, acc, sizeof(acc));
+  }
+};